@@ -16,8 +16,14 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <cstdlib>
 #include <utility>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
 #if defined(__cplusplus) && __cplusplus >= 201703L && defined(__has_include)
   #if __has_include(<filesystem>)
@@ -71,11 +77,187 @@ void load_plugins(PluginManager& plugin_manager, NodeRegisterMap& node_registers
   }
 }
 
+// set the value of a global from its string representation
+void set_global_from_string(Parameter& g, const std::string& value) {
+  if (g.is_type(typeid(std::string))) {
+    static_cast<ParameterByValue<std::string>&>(g).set(value);
+  } else if (g.is_type(typeid(float))) {
+    static_cast<ParameterByValue<float>&>(g).set(std::stof(value));
+  } else if(g.is_type(typeid(int))) {
+    static_cast<ParameterByValue<int>&>(g).set(std::stoi(value));
+  } else if(g.is_type(typeid(bool))) {
+    if(value == "true")
+      static_cast<ParameterByValue<bool>&>(g).set(true);
+    else if(value == "false")
+      static_cast<ParameterByValue<bool>&>(g).set(false);
+    else throw gfException("failed to get boolean from string\n");
+  }
+}
+
+// one line of a batch file, ie. the globals to set for one run of the flowchart
+struct BatchJob {
+  size_t line = 0;
+  std::vector<std::pair<std::string, std::string>> globals;
+  bool success = false;
+  std::string error;
+  double time_ms = 0;
+};
+
+// split a line of a csv file into its fields, fields can be enclosed in double quotes. Returns an empty vector if a 
+// quoted field is not closed
+vec1s split_csv_line(const std::string& line) {
+  vec1s fields{""};
+  bool quoted = false;
+  for (size_t i=0; i<line.size(); ++i) {
+    char c = line[i];
+    if (quoted) {
+      if (c=='"' && i+1<line.size() && line[i+1]=='"') {
+        fields.back() += '"';
+        ++i;
+      } else if (c=='"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c=='"') {
+      quoted = true;
+    } else if (c==',') {
+      fields.emplace_back();
+    } else if (c!='\r') {
+      fields.back() += c;
+    }
+  }
+  if (quoted) return {};
+  return fields;
+}
+
+// read the jobs from a JSONL file (one json object with global values per line) or a CSV file (global names in the 
+// first line, one job per following line). Empty lines are skipped
+std::vector<BatchJob> read_batch_jobs(const std::string& path) {
+  std::vector<BatchJob> jobs;
+  std::ifstream ifs(path);
+  bool jsonl = fs::path(path).extension() == ".jsonl" || fs::path(path).extension() == ".json";
+  vec1s header;
+  std::string line;
+  for (size_t line_nr=1; std::getline(ifs, line); ++line_nr) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    if (jsonl) {
+      BatchJob job;
+      job.line = line_nr;
+      json j;
+      try {
+        j = json::parse(line);
+      } catch (const json::parse_error& e) {
+        throw gfException("line " + std::to_string(line_nr) + " of " + path + " is not valid json: " + e.what());
+      }
+      if (!j.is_object())
+        throw gfException("line " + std::to_string(line_nr) + " of " + path + " is not a json object");
+      for (auto& [key, val] : j.items()) {
+        job.globals.emplace_back(key, val.is_string() ? val.get<std::string>() : val.dump());
+      }
+      jobs.push_back(job);
+    } else {
+      auto fields = split_csv_line(line);
+      if (fields.empty())
+        throw gfException("line " + std::to_string(line_nr) + " of " + path + " has an unclosed quote");
+      if (header.empty()) {
+        header = fields;
+        continue;
+      }
+      if (fields.size() != header.size())
+        throw gfException("line " + std::to_string(line_nr) + " of " + path + " has " + std::to_string(fields.size()) + " fields, expected " + std::to_string(header.size()));
+      BatchJob job;
+      job.line = line_nr;
+      for (size_t i=0; i<header.size(); ++i) {
+        job.globals.emplace_back(header[i], fields[i]);
+      }
+      jobs.push_back(job);
+    }
+  }
+  return jobs;
+}
+
+// copy of the flowchart with the globals of one job
+std::unique_ptr<NodeManager> create_job_flowchart(NodeManager& flowchart, const BatchJob& job) {
+  auto job_flowchart = std::make_unique<NodeManager>(flowchart.get_node_registers());
+  job_flowchart->copy_globals(flowchart);
+  for (auto& [key, value] : job.globals) {
+    auto g = job_flowchart->global_flowchart_params.find(key);
+    if (g == job_flowchart->global_flowchart_params.end())
+      throw gfException("unknown global " + key);
+    set_global_from_string(*g->second, value);
+  }
+  job_flowchart->clone_nodes(flowchart);
+  job_flowchart->copy_settings(flowchart);
+  // jobs that run at the same time stay within one memory budget together
+  job_flowchart->share_memory_budget(flowchart);
+  return job_flowchart;
+}
+
+// run the flowchart once for every job, n_workers jobs at a time. Each job runs on its own copy of the flowchart and 
+// its globals. Returns the number of jobs that failed
+size_t run_batch(NodeManager& flowchart, std::vector<BatchJob>& jobs, size_t n_workers) {
+  if (n_workers == 0) n_workers = std::thread::hardware_concurrency();
+  n_workers = std::max<size_t>(1, std::min(n_workers, jobs.size()));
+  std::atomic<size_t> next_job{0};
+  // node constructors are not thread safe, so the workers copy the flowchart one at a time
+  std::mutex copy_mutex;
+  std::vector<std::thread> workers;
+  for (size_t w=0; w<n_workers; ++w) {
+    workers.emplace_back([&]() {
+      for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+        auto& job = jobs[i];
+        auto start = std::chrono::steady_clock::now();
+        try {
+          std::unique_ptr<NodeManager> job_flowchart;
+          {
+            std::lock_guard<std::mutex> lock(copy_mutex);
+            job_flowchart = create_job_flowchart(flowchart, job);
+          }
+          job_flowchart->run_all();
+          job.success = true;
+          // the copy and its results are freed here, only the status of the job is kept
+        } catch (const std::exception& e) {
+          job.error = e.what();
+        }
+        job.time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  size_t n_failed = 0;
+  double total_ms = 0;
+  std::cout << "\nBatch summary\n";
+  for (auto& job : jobs) {
+    std::string globals;
+    for (auto& [key, value] : job.globals) {
+      globals += key + "=" + value + " ";
+    }
+    // some error messages end with a newline
+    while (!job.error.empty() && job.error.back() == '\n') job.error.pop_back();
+    std::cout << "line " << std::setw(6) << std::left << job.line 
+      << (job.success ? "OK    " : "FAILED") << " " << std::setw(10) << std::right << std::fixed << std::setprecision(1) << job.time_ms << "ms  " 
+      << globals << (job.success ? "" : "(" + job.error + ")") << "\n";
+    if (!job.success) ++n_failed;
+    total_ms += job.time_ms;
+  }
+  std::cout << jobs.size() - n_failed << " of " << jobs.size() << " jobs succeeded, total job time " << total_ms << "ms\n";
+  return n_failed;
+}
+
 int main(int argc, const char * argv[]) {
 
   std::string flowchart_path = "flowchart.json";
   std::string plugin_folder = GF_PLUGIN_FOLDER;
   std::string log_filename = "";
+  size_t n_threads = 1;
+  size_t memory_budget_mb = 0;
+  std::string cache_dir = "";
+  std::string trace_filename = "";
+  std::string batch_path = "";
+  size_t n_workers = 0;
+  int exit_code = 0;
   fs::path launch_path{fs::current_path()};
   fs::path flowchart_folder = launch_path;
   
@@ -101,6 +283,14 @@ int main(int argc, const char * argv[]) {
       } else return std::string();
     });
 
+    CLI::Option* opt_threads = cli.add_option("-j,--threads", n_threads, "Number of worker threads used to run the flowchart (0 = all cores). Overrides the flowchart setting");
+    CLI::Option* opt_trace = cli.add_option("--trace", trace_filename, "Write a Chrome trace event file with the timings of all nodes");
+    CLI::Option* opt_profile = cli.add_flag("--profile", "Print the metrics of all nodes after running the flowchart");
+    CLI::Option* opt_cache_dir = cli.add_option("--cache-dir", cache_dir, "Folder for cached node results (only used for nodes with use_disk_cache enabled). Overrides the flowchart setting");
+    CLI::Option* opt_stream = cli.add_flag("--stream", "Let nodes that support streaming process batches of features while the upstream node is still running");
+    CLI::Option* opt_memory_budget = cli.add_option("--memory-budget", memory_budget_mb, "Memory in MB that nodes running in parallel may use together, based on the memory use of the nodes in earlier runs. Overrides the flowchart setting");
+    CLI::Option* opt_release = cli.add_flag("--release-outputs", "Free the data of output terminals once all connected nodes have processed it, lowers the peak memory use");
+
     auto sc_flowchart = cli.add_subcommand("", "Load flowchart");
     CLI::Option* opt_flowchart_path = sc_flowchart->add_option("flowchart", flowchart_path, "Flowchart file");
     opt_flowchart_path->check(CLI::ExistingFile);
@@ -108,17 +298,26 @@ int main(int argc, const char * argv[]) {
       opt_flowchart_path->required();
     #endif
     auto sc_info = cli.add_subcommand("info", "Print info")->excludes(sc_flowchart);
+    auto sc_batch = cli.add_subcommand("batch", "Run a flowchart once for every line in a CSV or JSONL file with global values")->excludes(sc_flowchart)->excludes(sc_info);
+    CLI::Option* opt_batch_flowchart_path = sc_batch->add_option("flowchart", flowchart_path, "Flowchart file")->required();
+    opt_batch_flowchart_path->check(CLI::ExistingFile);
+    sc_batch->add_option("jobs", batch_path, "CSV file with global names in the first line or JSONL file with a json object per line, every other line is one job")->required()->check(CLI::ExistingFile);
+    sc_batch->add_option("-w,--workers", n_workers, "Number of jobs that run at the same time (0 = all cores)");
+    // the trace and metrics are recorded per flowchart, the copies that run the jobs do not report them
+    sc_batch->excludes(opt_trace)->excludes(opt_profile);
+    // globals passed on the command line are the defaults for all jobs
+    sc_batch->allow_extras();
 
     sc_info->parse_complete_callback([&plugin_manager, &node_registers, &plugin_folder](){
       load_plugins(plugin_manager, node_registers, plugin_folder, true);
     });
     
     std::map<std::string, std::vector<std::string>> globals_from_cli;
-    sc_flowchart->parse_complete_callback([&](){
+    auto load_flowchart = [&](){
       load_plugins(plugin_manager, node_registers, plugin_folder);
 
       // load flowchart from file
-      if(*opt_flowchart_path) {
+      if(*opt_flowchart_path || *opt_batch_flowchart_path) {
         // set current work directory to folder containing flowchart file
         auto abs_path = fs::absolute(fs::path(flowchart_path));
         flowchart_folder = abs_path.parent_path();
@@ -127,6 +326,12 @@ int main(int argc, const char * argv[]) {
         flowchart.load_json(flowchart_path);
         fs::current_path(launch_path);
       }
+    };
+    sc_flowchart->parse_complete_callback(load_flowchart);
+    // plugins and flowchart are loaded once for all jobs in the batch
+    sc_batch->parse_complete_callback([&](){
+      batch_path = fs::absolute(fs::path(batch_path)).string();
+      load_flowchart();
     });
 
     // handle cli globals
@@ -140,7 +345,12 @@ int main(int argc, const char * argv[]) {
         sc_globals.add_option("--"+key, (it->second), "");
         std::cout << "add global option " << key << "\n";
       }
-      sc_globals.parse(cli.remaining_for_passthrough());
+      auto remaining = cli.remaining_for_passthrough();
+      if(*sc_batch) {
+        auto remaining_batch = sc_batch->remaining_for_passthrough();
+        remaining.insert(remaining.end(), remaining_batch.begin(), remaining_batch.end());
+      }
+      sc_globals.parse(remaining);
     });
 
     try {
@@ -164,23 +374,7 @@ int main(int argc, const char * argv[]) {
           
           auto& g = flowchart.global_flowchart_params[key];
           try{
-            if (g->is_type(typeid(std::string))) {
-              auto* gptr = static_cast<ParameterByValue<std::string>*>(g.get());
-              gptr->set(concat_values);
-            } else if (g->is_type(typeid(float))) {
-              auto* gptr = static_cast<ParameterByValue<float>*>(g.get());
-              gptr->set(std::stof(concat_values));
-            } else if(g->is_type(typeid(int))) {
-              auto* gptr = static_cast<ParameterByValue<int>*>(g.get());
-              gptr->set(std::stoi(concat_values));
-            } else if(g->is_type(typeid(bool))) {
-              auto* gptr = static_cast<ParameterByValue<bool>*>(g.get());
-              if(concat_values == "true")
-                gptr->set(true);
-              else if(concat_values == "false")
-                gptr->set(false);
-              else throw gfException("failed to get boolean from string\n");
-            }
+            set_global_from_string(*g, concat_values);
           } catch (const std::exception& e) {
             std::cout << "Error in parsing global parameters\n";
             std::cout << e.what();
@@ -190,6 +384,26 @@ int main(int argc, const char * argv[]) {
       }
     }
 
+    if(*opt_threads) {
+      flowchart.n_threads = n_threads;
+    }
+    if(*opt_stream) {
+      flowchart.streaming = true;
+    }
+    if(*opt_memory_budget) {
+      flowchart.memory_budget_kb = memory_budget_mb * 1024;
+    }
+    if(*opt_release) {
+      flowchart.release_consumed_outputs = true;
+    }
+    if(*opt_cache_dir) {
+      flowchart.cache_dir = fs::absolute(fs::path(cache_dir)).string();
+    }
+    if(*opt_trace) {
+      trace_filename = fs::absolute(fs::path(trace_filename)).string();
+      flowchart.record_trace = true;
+    }
+
     std::ofstream logfile;
     if(*opt_log) {
       logfile.open(log_filename);
@@ -199,13 +413,34 @@ int main(int argc, const char * argv[]) {
 
     // launch gui or just run the flowchart in cli mode
     fs::current_path(flowchart_folder);
+    if(*sc_batch) {
+      try {
+        auto jobs = read_batch_jobs(batch_path);
+        if(jobs.empty())
+          throw gfException("no jobs in " + batch_path);
+        if(run_batch(flowchart, jobs, n_workers))
+          exit_code = 1;
+      } catch (const std::exception& e) {
+        std::cout << "Error in reading batch file\n";
+        std::cout << e.what() << "\n";
+        exit_code = 1;
+      }
+    } else {
     #ifdef GF_BUILD_WITH_GUI
       if(node_registers.size()==0)
         load_plugins(plugin_manager, node_registers, plugin_folder);
       launch_gui(flowchart, flowchart_path);
     #else
       flowchart.run_all();
+      if(*opt_profile) {
+        flowchart.print_metrics(std::cout);
+        flowchart.print_memory_report(std::cout);
+      }
     #endif
+    }
+    if(*opt_trace) {
+      flowchart.dump_trace(trace_filename);
+    }
   }
   // NOTICE that we first must destroy any related node_registers before we can unload the plugin_manager!
   plugin_manager.unload();
@@ -213,5 +448,5 @@ int main(int argc, const char * argv[]) {
   std::cout.rdbuf(cout_rdbuf);
   std::cerr.rdbuf(cerr_rdbuf);
   
-  return 0;
+  return exit_code;
 }
@@ -1,7 +1,8 @@
 file(READ ${PROJECT_SOURCE_DIR}/src/geoflow/common.hpp s1)
 file(READ ${PROJECT_SOURCE_DIR}/src/geoflow/parameters.hpp s2)
 file(READ ${PROJECT_SOURCE_DIR}/src/geoflow/geoflow.hpp s3)
-string(CONCAT GF_SHARED_HEADERS ${s1} ${s2} ${s3})
+file(READ ${PROJECT_SOURCE_DIR}/src/geoflow/serialisation.hpp s4)
+string(CONCAT GF_SHARED_HEADERS ${s1} ${s2} ${s3} ${s4})
 string(MD5 GF_SHARED_HEADERS_HASH ${GF_SHARED_HEADERS})
 message(STATUS "Setting Geoflow shared header hash to ${GF_SHARED_HEADERS_HASH}")
 file(WRITE ${OUTPUT_FILE} "#define GF_SHARED_HEADERS_HASH \"${GF_SHARED_HEADERS_HASH}\"\n")
\ No newline at end of file
@@ -15,12 +15,41 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
 
 #include "common.hpp"
+#include "kernels.hpp"
 
 namespace geoflow
 {
 
+// the null bitmap of AttributeColumn, bit i is set if value i is valid
+static void set_bit(std::vector<uint64_t>& bits, size_t i, bool value)
+{
+  if (bits.size() <= i / 64)
+    bits.resize(i / 64 + 1, 0);
+  if (value)
+    bits[i / 64] |= uint64_t(1) << (i % 64);
+  else
+    bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+}
+static bool get_bit(const std::vector<uint64_t>& bits, size_t i)
+{
+  return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+// extends box with the n x,y,z triplets in xyz
+static void add_to_box(Box& box, const float* xyz, size_t n)
+{
+  if (n == 0) return;
+  arr3f pmin, pmax;
+  kernels::minmax_xyz(xyz, n, pmin.data(), pmax.data());
+  box.add(pmin);
+  box.add(pmax);
+}
+
 Box::Box()
 {
   clear();
@@ -75,8 +104,8 @@ void Box::add(Box &otherBox)
 }
 void Box::add(vec3f &vec)
 {
-  for (auto &p : vec)
-    add(p);
+  if (!vec.empty())
+    add_to_box(*this, vec[0].data(), vec.size());
 }
 float Box::size_x() const
 {
@@ -119,6 +148,50 @@ size_t Geometry::dimension()
 {
   return 3;
 }
+void Geometry::translate_vertices(const arr3d& d)
+{
+  if (vertex_count() == 0) return;
+  kernels::translate_xyz(get_data_ptr(), vertex_count(), d.data());
+}
+const arr3d& Geometry::offset() const
+{
+  return offset_;
+}
+void Geometry::set_offset(const arr3d& offset)
+{
+  offset_ = offset;
+}
+void Geometry::rebase(const arr3d& offset)
+{
+  arr3d d = {offset_[0] - offset[0], offset_[1] - offset[1], offset_[2] - offset[2]};
+  offset_ = offset;
+  if (d == arr3d{0, 0, 0}) return;
+  translate_vertices(d);
+  bbox.reset();
+}
+arr3f Geometry::to_local(const arr3d& p) const
+{
+  return {float(p[0] - offset_[0]), float(p[1] - offset_[1]), float(p[2] - offset_[2])};
+}
+arr3d Geometry::to_global(const arr3f& p) const
+{
+  return {p[0] + offset_[0], p[1] + offset_[1], p[2] + offset_[2]};
+}
+
+vec3f to_local(const vec3d& points, const arr3d& offset)
+{
+  vec3f result(points.size());
+  if (!points.empty())
+    kernels::to_local(points[0].data(), points.size(), offset.data(), result[0].data());
+  return result;
+}
+vec3d to_global(const vec3f& points, const arr3d& offset)
+{
+  vec3d result(points.size());
+  if (!points.empty())
+    kernels::to_global(points[0].data(), points.size(), offset.data(), result[0].data());
+  return result;
+}
 
 // geometry types:
 
@@ -127,10 +200,7 @@ void LinearRing::compute_box()
   if (!bbox.has_value())
   {
     bbox = Box();
-    for (auto &t : *this)
-    {
-      bbox->add(t);
-    }
+    bbox->add(*this);
   }
 }
 size_t LinearRing::vertex_count() const
@@ -141,6 +211,14 @@ float *LinearRing::get_data_ptr()
 {
   return (*this)[0].data();
 }
+void LinearRing::translate_vertices(const arr3d& d)
+{
+  if (!empty())
+    kernels::translate_xyz((*this)[0].data(), size(), d.data());
+  for (auto &ring : interior_rings_)
+    if (!ring.empty())
+      kernels::translate_xyz(ring[0].data(), ring.size(), d.data());
+}
 std::vector<vec3f>& LinearRing::interior_rings() {
   return interior_rings_;
 }
@@ -158,8 +236,7 @@ void Segment::compute_box()
   if (!bbox.has_value())
   {
     bbox = Box();
-    bbox->add((*this)[0]);
-    bbox->add((*this)[1]);
+    add_to_box(*bbox, (*this)[0].data(), 2);
   }
 }
 size_t Segment::vertex_count() const
@@ -176,10 +253,7 @@ void LineString::compute_box()
   if (!bbox.has_value())
   {
     bbox = Box();
-    for (auto &t : *this)
-    {
-      bbox->add(t);
-    }
+    bbox->add(*this);
   }
 }
 size_t LineString::vertex_count() const
@@ -208,6 +282,173 @@ float *PointCollection::get_data_ptr()
   return (*this)[0].data();
 }
 
+PointCloud::PointCloud(const PointCollection& points)
+{
+  offset_ = points.offset();
+  reserve(points.size());
+  for (auto &p : points)
+    push_back(p);
+}
+size_t PointCloud::size() const
+{
+  return x_.size();
+}
+bool PointCloud::empty() const
+{
+  return x_.empty();
+}
+void PointCloud::reserve(size_t n)
+{
+  x_.reserve(n);
+  y_.reserve(n);
+  z_.reserve(n);
+  for (auto &[name, values] : attributes_)
+    values.reserve(n);
+}
+void PointCloud::resize(size_t n)
+{
+  x_.resize(n);
+  y_.resize(n);
+  z_.resize(n);
+  for (auto &[name, values] : attributes_)
+    values.resize(n);
+  bbox.reset();
+}
+void PointCloud::clear()
+{
+  resize(0);
+}
+void PointCloud::push_back(const arr3f& p)
+{
+  x_.push_back(p[0]);
+  y_.push_back(p[1]);
+  z_.push_back(p[2]);
+  for (auto &[name, values] : attributes_)
+    values.push_back(0);
+  bbox.reset();
+}
+arr3f PointCloud::operator[](size_t i) const
+{
+  return {x_[i], y_[i], z_[i]};
+}
+vec1f& PointCloud::x()
+{
+  return x_;
+}
+vec1f& PointCloud::y()
+{
+  return y_;
+}
+vec1f& PointCloud::z()
+{
+  return z_;
+}
+const vec1f& PointCloud::x() const
+{
+  return x_;
+}
+const vec1f& PointCloud::y() const
+{
+  return y_;
+}
+const vec1f& PointCloud::z() const
+{
+  return z_;
+}
+vec1f& PointCloud::add_attribute(const std::string& name)
+{
+  auto &values = attributes_[name];
+  values.resize(size());
+  return values;
+}
+bool PointCloud::has_attribute(const std::string& name) const
+{
+  return attributes_.count(name) > 0;
+}
+vec1f& PointCloud::attribute(const std::string& name)
+{
+  return attributes_.at(name);
+}
+const vec1f& PointCloud::attribute(const std::string& name) const
+{
+  return attributes_.at(name);
+}
+std::unordered_map<std::string, vec1f>& PointCloud::attributes()
+{
+  return attributes_;
+}
+const std::unordered_map<std::string, vec1f>& PointCloud::attributes() const
+{
+  return attributes_;
+}
+void PointCloud::translate(const std::array<double, 3>& offset)
+{
+  translate_vertices(offset);
+  bbox.reset();
+}
+PointCloud PointCloud::filter(const Box& box, bool use_z) const
+{
+  PointCloud result;
+  result.offset_ = offset_;
+  if (empty() || box.isEmpty()) return result;
+
+  std::vector<unsigned char> mask(size(), 1);
+  auto pmin = box.min(), pmax = box.max();
+  kernels::mask_range(x_.data(), size(), pmin[0], pmax[0], mask.data());
+  kernels::mask_range(y_.data(), size(), pmin[1], pmax[1], mask.data());
+  if (use_z)
+    kernels::mask_range(z_.data(), size(), pmin[2], pmax[2], mask.data());
+
+  size_t n = std::count(mask.begin(), mask.end(), 1);
+  auto compact = [&mask, n](const vec1f& src, vec1f& dst) {
+    dst.reserve(n);
+    for (size_t i=0; i<src.size(); ++i)
+      if (mask[i]) dst.push_back(src[i]);
+  };
+  compact(x_, result.x_);
+  compact(y_, result.y_);
+  compact(z_, result.z_);
+  for (auto &[name, values] : attributes_)
+    compact(values, result.attributes_[name]);
+  return result;
+}
+PointCollection PointCloud::to_point_collection() const
+{
+  PointCollection points;
+  points.set_offset(offset_);
+  points.reserve(size());
+  for (size_t i=0; i<size(); ++i)
+    points.push_back({x_[i], y_[i], z_[i]});
+  return points;
+}
+size_t PointCloud::vertex_count() const
+{
+  return size();
+}
+void PointCloud::translate_vertices(const arr3d& d)
+{
+  kernels::add_double(x_.data(), size(), d[0]);
+  kernels::add_double(y_.data(), size(), d[1]);
+  kernels::add_double(z_.data(), size(), d[2]);
+}
+void PointCloud::compute_box()
+{
+  if (!bbox.has_value())
+  {
+    bbox = Box();
+    if (empty()) return;
+    arr3f pmin, pmax;
+    kernels::minmax(x_.data(), size(), pmin[0], pmax[0]);
+    kernels::minmax(y_.data(), size(), pmin[1], pmax[1]);
+    kernels::minmax(z_.data(), size(), pmin[2], pmax[2]);
+    bbox->set(pmin, pmax);
+  }
+}
+float *PointCloud::get_data_ptr()
+{
+  return nullptr;
+}
+
 size_t TriangleCollection::vertex_count() const
 {
   return size() * 3;
@@ -217,12 +458,8 @@ void TriangleCollection::compute_box()
   if (!bbox.has_value())
   {
     bbox = Box();
-    for (auto &t : *this)
-    {
-      bbox->add(t[0]);
-      bbox->add(t[1]);
-      bbox->add(t[2]);
-    }
+    if (!empty())
+      add_to_box(*bbox, (*this)[0][0].data(), vertex_count());
   }
 }
 float *TriangleCollection::get_data_ptr()
@@ -239,11 +476,8 @@ void SegmentCollection::compute_box()
   if (!bbox.has_value())
   {
     bbox = Box();
-    for (auto &t : *this)
-    {
-      bbox->add(t[0]);
-      bbox->add(t[1]);
-    }
+    if (!empty())
+      add_to_box(*bbox, (*this)[0][0].data(), vertex_count());
   }
 }
 float *SegmentCollection::get_data_ptr()
@@ -271,6 +505,12 @@ void LineStringCollection::compute_box()
     }
   }
 }
+void LineStringCollection::translate_vertices(const arr3d& d)
+{
+  for (auto &vec : *this)
+    if (!vec.empty())
+      kernels::translate_xyz(vec[0].data(), vec.size(), d.data());
+}
 float *LineStringCollection::get_data_ptr()
 {
   return (*this)[0][0].data();
@@ -296,11 +536,387 @@ void LinearRingCollection::compute_box()
     }
   }
 }
+void LinearRingCollection::translate_vertices(const arr3d& d)
+{
+  for (auto &vec : *this)
+    if (!vec.empty())
+      kernels::translate_xyz(vec[0].data(), vec.size(), d.data());
+}
 float *LinearRingCollection::get_data_ptr()
 {
   return (*this)[0][0].data();
 }
 
+PackedRingCollection::PackedRingCollection()
+{
+  clear();
+}
+PackedRingCollection::PackedRingCollection(const std::vector<vec3f>& rings)
+{
+  clear();
+  size_t n = 0;
+  for (auto &ring : rings)
+    n += ring.size();
+  reserve(rings.size(), n);
+  for (auto &ring : rings)
+    push_back(ring);
+}
+size_t PackedRingCollection::size() const
+{
+  return offsets_.size() - 1;
+}
+bool PackedRingCollection::empty() const
+{
+  return size() == 0;
+}
+void PackedRingCollection::reserve(size_t ring_count, size_t vertex_count)
+{
+  offsets_.reserve(ring_count + 1);
+  vertices_.reserve(vertex_count);
+}
+void PackedRingCollection::clear()
+{
+  vertices_.clear();
+  offsets_.assign(1, 0);
+  bbox.reset();
+}
+void PackedRingCollection::push_back(const vec3f& ring)
+{
+  vertices_.insert(vertices_.end(), ring.begin(), ring.end());
+  end_ring();
+}
+void PackedRingCollection::add_vertex(const arr3f& p)
+{
+  vertices_.push_back(p);
+}
+void PackedRingCollection::end_ring()
+{
+  offsets_.push_back(vertices_.size());
+  bbox.reset();
+}
+size_t PackedRingCollection::ring_size(size_t i) const
+{
+  return offsets_[i+1] - offsets_[i];
+}
+arr3f* PackedRingCollection::ring_data(size_t i)
+{
+  return vertices_.data() + offsets_[i];
+}
+const arr3f* PackedRingCollection::ring_data(size_t i) const
+{
+  return vertices_.data() + offsets_[i];
+}
+vec3f PackedRingCollection::ring(size_t i) const
+{
+  return vec3f(ring_data(i), ring_data(i) + ring_size(i));
+}
+std::vector<vec3f> PackedRingCollection::unpack() const
+{
+  std::vector<vec3f> rings;
+  rings.reserve(size());
+  for (size_t i=0; i<size(); ++i)
+    rings.push_back(ring(i));
+  return rings;
+}
+vec3f& PackedRingCollection::vertices()
+{
+  return vertices_;
+}
+const vec3f& PackedRingCollection::vertices() const
+{
+  return vertices_;
+}
+std::vector<size_t>& PackedRingCollection::offsets()
+{
+  return offsets_;
+}
+const std::vector<size_t>& PackedRingCollection::offsets() const
+{
+  return offsets_;
+}
+size_t PackedRingCollection::vertex_count() const
+{
+  return vertices_.size();
+}
+void PackedRingCollection::compute_box()
+{
+  if (!bbox.has_value())
+  {
+    bbox = Box();
+    bbox->add(vertices_);
+  }
+}
+float *PackedRingCollection::get_data_ptr()
+{
+  if (vertices_.empty()) return nullptr;
+  return vertices_[0].data();
+}
+
+PackedLineStringCollection::PackedLineStringCollection(const LineStringCollection& linestrings)
+  : PackedRingCollection(linestrings)
+{
+  offset_ = linestrings.offset();
+}
+LineStringCollection PackedLineStringCollection::to_collection() const
+{
+  LineStringCollection linestrings;
+  linestrings.set_offset(offset_);
+  for (size_t i=0; i<size(); ++i)
+    linestrings.push_back(ring(i));
+  return linestrings;
+}
+
+PackedLinearRingCollection::PackedLinearRingCollection(const LinearRingCollection& rings)
+  : PackedRingCollection(rings)
+{
+  offset_ = rings.offset();
+}
+LinearRingCollection PackedLinearRingCollection::to_collection() const
+{
+  LinearRingCollection rings;
+  rings.set_offset(offset_);
+  for (size_t i=0; i<size(); ++i)
+    rings.push_back(ring(i));
+  return rings;
+}
+
+AttributeColumn::AttributeColumn(AttributeType type)
+  : data_(std::make_shared<Data>())
+{
+  data_->type = type;
+}
+void AttributeColumn::detach()
+{
+  if (data_.use_count() == 1 && begin_ == 0 && size_ == data_->size) return;
+  auto data = std::make_shared<Data>();
+  data->type = data_->type;
+  auto copy_range = [this](const auto& src, auto& dst) {
+    if (!src.empty())
+      dst.assign(src.begin() + begin_, src.begin() + begin_ + size_);
+  };
+  copy_range(data_->bools, data->bools);
+  copy_range(data_->ints, data->ints);
+  copy_range(data_->floats, data->floats);
+  copy_range(data_->codes, data->codes);
+  data->dictionary = data_->dictionary;
+  data->dictionary_index = data_->dictionary_index;
+  if (!data_->valid.empty())
+  {
+    for (size_t i=0; i<size_; ++i)
+      set_bit(data->valid, i, !is_null(i));
+  }
+  data->size = size_;
+  data_ = data;
+  begin_ = 0;
+}
+AttributeType AttributeColumn::type() const
+{
+  return data_->type;
+}
+size_t AttributeColumn::size() const
+{
+  return size_;
+}
+bool AttributeColumn::is_null(size_t i) const
+{
+  if (data_->valid.empty()) return false;
+  return !get_bit(data_->valid, begin_ + i);
+}
+bool AttributeColumn::has_nulls() const
+{
+  if (data_->valid.empty()) return false;
+  for (size_t i=0; i<size_; ++i)
+    if (is_null(i)) return true;
+  return false;
+}
+void AttributeColumn::push_back(const attribute_value& value)
+{
+  if (value.index() != size_t(data_->type))
+    throw std::invalid_argument("attribute value does not match the type of the column");
+  detach();
+  auto &d = *data_;
+  switch (d.type)
+  {
+    case AttributeTypeBool: d.bools.push_back(std::get<bool>(value)); break;
+    case AttributeTypeInt: d.ints.push_back(std::get<int>(value)); break;
+    case AttributeTypeFloat: d.floats.push_back(std::get<float>(value)); break;
+    case AttributeTypeString:
+    {
+      auto &str = std::get<std::string>(value);
+      auto it = d.dictionary_index.find(str);
+      if (it == d.dictionary_index.end())
+      {
+        it = d.dictionary_index.emplace(str, uint32_t(d.dictionary.size())).first;
+        d.dictionary.push_back(str);
+      }
+      d.codes.push_back(it->second);
+      break;
+    }
+  }
+  if (!d.valid.empty())
+    set_bit(d.valid, d.size, true);
+  ++d.size;
+  ++size_;
+}
+void AttributeColumn::push_null()
+{
+  detach();
+  auto &d = *data_;
+  switch (d.type)
+  {
+    case AttributeTypeBool: d.bools.push_back(0); break;
+    case AttributeTypeInt: d.ints.push_back(0); break;
+    case AttributeTypeFloat: d.floats.push_back(0); break;
+    case AttributeTypeString: d.codes.push_back(0); break;
+  }
+  // the bitmap is only created for the first null
+  if (d.valid.empty())
+  {
+    for (size_t i=0; i<d.size; ++i)
+      set_bit(d.valid, i, true);
+  }
+  set_bit(d.valid, d.size, false);
+  ++d.size;
+  ++size_;
+}
+std::optional<attribute_value> AttributeColumn::get(size_t i) const
+{
+  if (is_null(i)) return std::nullopt;
+  size_t j = begin_ + i;
+  switch (data_->type)
+  {
+    case AttributeTypeBool: return attribute_value(bool(data_->bools[j]));
+    case AttributeTypeInt: return attribute_value(data_->ints[j]);
+    case AttributeTypeFloat: return attribute_value(data_->floats[j]);
+    case AttributeTypeString: return attribute_value(data_->dictionary[data_->codes[j]]);
+  }
+  return std::nullopt;
+}
+const uint8_t* AttributeColumn::bools() const
+{
+  return data_->bools.data() + begin_;
+}
+const int* AttributeColumn::ints() const
+{
+  return data_->ints.data() + begin_;
+}
+const float* AttributeColumn::floats() const
+{
+  return data_->floats.data() + begin_;
+}
+const uint32_t* AttributeColumn::codes() const
+{
+  return data_->codes.data() + begin_;
+}
+const vec1s& AttributeColumn::dictionary() const
+{
+  return data_->dictionary;
+}
+AttributeColumn AttributeColumn::slice(size_t begin, size_t n) const
+{
+  if (begin + n > size_)
+    throw std::out_of_range("slice exceeds the size of the attribute column");
+  AttributeColumn result(*this);
+  result.begin_ = begin_ + begin;
+  result.size_ = n;
+  return result;
+}
+
+AttributeTable::AttributeTable(const AttributeMap& attributes)
+{
+  for (auto &[name, values] : attributes)
+  {
+    AttributeColumn column(values.empty() ? AttributeTypeFloat : AttributeType(values[0].index()));
+    for (auto &value : values)
+      column.push_back(value);
+    columns_.emplace_back(name, column);
+  }
+}
+size_t AttributeTable::size() const
+{
+  if (columns_.empty()) return 0;
+  return columns_[0].second.size();
+}
+size_t AttributeTable::column_count() const
+{
+  return columns_.size();
+}
+bool AttributeTable::has_column(const std::string& name) const
+{
+  for (auto &[column_name, column] : columns_)
+    if (column_name == name) return true;
+  return false;
+}
+AttributeColumn& AttributeTable::add_column(const std::string& name, AttributeType type)
+{
+  for (auto &[column_name, column] : columns_)
+    if (column_name == name) return column;
+  AttributeColumn column(type);
+  for (size_t i=0, n=size(); i<n; ++i)
+    column.push_null();
+  columns_.emplace_back(name, column);
+  return columns_.back().second;
+}
+AttributeColumn& AttributeTable::add_column(const std::string& name, const AttributeColumn& column)
+{
+  for (auto &[column_name, existing] : columns_)
+  {
+    if (column_name == name)
+    {
+      existing = column;
+      return existing;
+    }
+  }
+  columns_.emplace_back(name, column);
+  return columns_.back().second;
+}
+AttributeColumn& AttributeTable::column(const std::string& name)
+{
+  for (auto &[column_name, column] : columns_)
+    if (column_name == name) return column;
+  throw std::out_of_range("no attribute column named " + name);
+}
+const AttributeColumn& AttributeTable::column(const std::string& name) const
+{
+  for (auto &[column_name, column] : columns_)
+    if (column_name == name) return column;
+  throw std::out_of_range("no attribute column named " + name);
+}
+vec1s AttributeTable::column_names() const
+{
+  vec1s names;
+  for (auto &[name, column] : columns_)
+    names.push_back(name);
+  return names;
+}
+AttributeTable AttributeTable::slice(size_t begin, size_t n) const
+{
+  AttributeTable result;
+  for (auto &[name, column] : columns_)
+    result.columns_.emplace_back(name, column.slice(begin, n));
+  return result;
+}
+AttributeMap AttributeTable::to_attribute_map() const
+{
+  AttributeMap attributes;
+  for (auto &[name, column] : columns_)
+  {
+    attribute_value null_value;
+    switch (column.type())
+    {
+      case AttributeTypeBool: null_value = false; break;
+      case AttributeTypeInt: null_value = 0; break;
+      case AttributeTypeFloat: null_value = 0.f; break;
+      case AttributeTypeString: null_value = std::string(); break;
+    }
+    auto &values = attributes[name];
+    values.reserve(column.size());
+    for (size_t i=0; i<column.size(); ++i)
+      values.push_back(column.get(i).value_or(null_value));
+  }
+  return attributes;
+}
+
 void Mesh::push_polygon(LinearRing& polygon, int label) {
   polygons_.push_back(polygon);
   labels_.push_back(label);
@@ -384,6 +1000,32 @@ const TriangleCollection& MultiTriangleCollection::tri_at(size_t i) const
   return trianglecollections_.at(i);
 }
 
+AttributeTable MultiTriangleCollection::get_attribute_table() const
+{
+  // the column types are taken from the first value of each attribute
+  std::vector<std::pair<std::string, AttributeType>> column_types;
+  std::unordered_map<std::string, AttributeType> seen;
+  for (auto &attributes : attributes_)
+    for (auto &[name, values] : attributes)
+      if (!values.empty() && seen.emplace(name, AttributeType(values[0].index())).second)
+        column_types.emplace_back(name, AttributeType(values[0].index()));
+
+  AttributeTable table;
+  for (auto &[name, type] : column_types)
+  {
+    auto &column = table.add_column(name, type);
+    for (auto &attributes : attributes_)
+    {
+      auto it = attributes.find(name);
+      if (it != attributes.end() && !it->second.empty() && it->second[0].index() == size_t(type))
+        column.push_back(it->second[0]);
+      else
+        column.push_null();
+    }
+  }
+  return table;
+}
+
 AttributeMap& MultiTriangleCollection::attr_at(size_t i)
 {
   return attributes_.at(i);
@@ -393,4 +1035,366 @@ const AttributeMap& MultiTriangleCollection::attr_at(size_t i) const
   return attributes_.at(i);
 }
 
+// maps coordinates to the index of the first vertex with exactly these coordinates
+class VertexIndex
+{
+  struct Hash {
+    size_t operator()(const arr3f& p) const
+    {
+      uint32_t b[3];
+      std::memcpy(b, p.data(), sizeof(b));
+      return (size_t(b[0]) * 73856093) ^ (size_t(b[1]) * 19349663) ^ (size_t(b[2]) * 83492791);
+    }
+  };
+  std::unordered_map<arr3f, uint32_t, Hash> index_;
+  IndexedMesh& mesh_;
+
+public:
+  VertexIndex(IndexedMesh& mesh) : mesh_(mesh) {}
+  uint32_t get(const arr3f& p)
+  {
+    auto it = index_.find(p);
+    if (it != index_.end()) return it->second;
+    auto i = mesh_.add_vertex(p);
+    index_.emplace(p, i);
+    return i;
+  }
+  std::vector<uint32_t> get(const vec3f& ring)
+  {
+    std::vector<uint32_t> result;
+    result.reserve(ring.size());
+    for (auto &p : ring)
+      result.push_back(get(p));
+    return result;
+  }
+};
+
+IndexedMesh::IndexedMesh()
+{
+  clear();
+}
+IndexedMesh::IndexedMesh(const TriangleCollection& triangles)
+{
+  clear();
+  offset_ = triangles.offset();
+  VertexIndex vertex_index(*this);
+  indices_.reserve(triangles.size() * 3);
+  for (auto &t : triangles)
+    add_triangle(vertex_index.get(t[0]), vertex_index.get(t[1]), vertex_index.get(t[2]));
+}
+IndexedMesh::IndexedMesh(const Mesh& mesh)
+{
+  clear();
+  auto &polygons = mesh.get_polygons();
+  auto &labels = mesh.get_labels();
+  if (!polygons.empty())
+    offset_ = polygons[0].offset();
+  VertexIndex vertex_index(*this);
+  // the polygons may have different offsets, their vertices are moved onto the offset of the first polygon
+  vec3f rebased;
+  auto get_ring = [&](const vec3f& ring, const arr3d& d) {
+    if (d == arr3d{0, 0, 0} || ring.empty()) return vertex_index.get(ring);
+    rebased = ring;
+    kernels::translate_xyz(rebased[0].data(), rebased.size(), d.data());
+    return vertex_index.get(rebased);
+  };
+  for (size_t i=0; i<polygons.size(); ++i)
+  {
+    auto &offset = polygons[i].offset();
+    arr3d d = {offset[0] - offset_[0], offset[1] - offset_[1], offset[2] - offset_[2]};
+    std::vector<std::vector<uint32_t>> interior;
+    for (auto &ring : polygons[i].interior_rings())
+      interior.push_back(get_ring(ring, d));
+    add_polygon(get_ring(polygons[i], d), interior, i < labels.size() ? labels[i] : 0);
+  }
+}
+uint32_t IndexedMesh::add_vertex(const arr3f& p)
+{
+  vertices_.push_back(p);
+  bbox.reset();
+  return uint32_t(vertices_.size() - 1);
+}
+void IndexedMesh::add_polygon(const std::vector<uint32_t>& exterior, const std::vector<std::vector<uint32_t>>& interior, int label)
+{
+  indices_.insert(indices_.end(), exterior.begin(), exterior.end());
+  ring_offsets_.push_back(uint32_t(indices_.size()));
+  for (auto &ring : interior)
+  {
+    indices_.insert(indices_.end(), ring.begin(), ring.end());
+    ring_offsets_.push_back(uint32_t(indices_.size()));
+  }
+  polygon_offsets_.push_back(uint32_t(ring_offsets_.size() - 1));
+  labels_.push_back(label);
+}
+void IndexedMesh::add_triangle(uint32_t a, uint32_t b, uint32_t c, int label)
+{
+  indices_.push_back(a);
+  indices_.push_back(b);
+  indices_.push_back(c);
+  ring_offsets_.push_back(uint32_t(indices_.size()));
+  polygon_offsets_.push_back(uint32_t(ring_offsets_.size() - 1));
+  labels_.push_back(label);
+}
+void IndexedMesh::clear()
+{
+  vertices_.clear();
+  indices_.clear();
+  ring_offsets_.assign(1, 0);
+  polygon_offsets_.assign(1, 0);
+  labels_.clear();
+  bbox.reset();
+}
+size_t IndexedMesh::polygon_count() const
+{
+  return polygon_offsets_.size() - 1;
+}
+size_t IndexedMesh::ring_count() const
+{
+  return ring_offsets_.size() - 1;
+}
+bool IndexedMesh::is_triangle_mesh() const
+{
+  return ring_count() == polygon_count() && indices_.size() == 3 * ring_count();
+}
+vec3f& IndexedMesh::vertices()
+{
+  return vertices_;
+}
+const vec3f& IndexedMesh::vertices() const
+{
+  return vertices_;
+}
+std::vector<uint32_t>& IndexedMesh::indices()
+{
+  return indices_;
+}
+const std::vector<uint32_t>& IndexedMesh::indices() const
+{
+  return indices_;
+}
+std::vector<uint32_t>& IndexedMesh::ring_offsets()
+{
+  return ring_offsets_;
+}
+const std::vector<uint32_t>& IndexedMesh::ring_offsets() const
+{
+  return ring_offsets_;
+}
+std::vector<uint32_t>& IndexedMesh::polygon_offsets()
+{
+  return polygon_offsets_;
+}
+const std::vector<uint32_t>& IndexedMesh::polygon_offsets() const
+{
+  return polygon_offsets_;
+}
+std::vector<int>& IndexedMesh::labels()
+{
+  return labels_;
+}
+const std::vector<int>& IndexedMesh::labels() const
+{
+  return labels_;
+}
+// triangulates a polygon by ear clipping and appends the triangles to result, with the same orientation as the 
+// exterior ring. Each interior ring is first joined to the exterior ring by a bridge edge, so that the polygon becomes 
+// a single ring. The polygon is projected on the coordinate plane that is closest to the plane of its exterior ring
+static void triangulate_polygon(const vec3f& vertices, std::vector<std::vector<uint32_t>> rings, std::vector<uint32_t>& result)
+{
+  // a closing vertex that repeats the first one is not part of the triangulation
+  for (auto& ring : rings)
+    if (ring.size() > 3 && ring.back() == ring.front()) ring.pop_back();
+  auto& exterior = rings[0];
+  if (exterior.size() < 3) return;
+  if (exterior.size() == 3 && rings.size() == 1)
+  {
+    result.insert(result.end(), exterior.begin(), exterior.end());
+    return;
+  }
+
+  // normal of the exterior ring with Newell's method, it determines the projection and the orientation
+  arr3d normal = {0, 0, 0};
+  size_t n = exterior.size();
+  for (size_t i=0; i<n; ++i)
+  {
+    auto &a = vertices[exterior[i]], &b = vertices[exterior[(i+1)%n]];
+    normal[0] += (double(a[1]) - b[1]) * (double(a[2]) + b[2]);
+    normal[1] += (double(a[2]) - b[2]) * (double(a[0]) + b[0]);
+    normal[2] += (double(a[0]) - b[0]) * (double(a[1]) + b[1]);
+  }
+  size_t axis = 2;
+  if (std::abs(normal[0]) > std::abs(normal[axis])) axis = 0;
+  if (std::abs(normal[1]) > std::abs(normal[axis])) axis = 1;
+  size_t u = (axis+1)%3, v = (axis+2)%3;
+  double sign = normal[axis] < 0 ? -1 : 1;
+
+  // twice the signed area of triangle abc in the projection, positive if it has the orientation of the exterior ring
+  auto cross = [&](uint32_t a, uint32_t b, uint32_t c) {
+    auto &pa = vertices[a], &pb = vertices[b], &pc = vertices[c];
+    return sign * ((double(pb[u]) - pa[u]) * (double(pc[v]) - pa[v]) - (double(pb[v]) - pa[v]) * (double(pc[u]) - pa[u]));
+  };
+  auto inside = [&](uint32_t p, uint32_t a, uint32_t b, uint32_t c) {
+    return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+  };
+  auto same = [&](uint32_t a, uint32_t b) { return a == b || vertices[a] == vertices[b]; };
+  // true if segments ab and cd cross, segments that share an end point do not cross
+  auto crosses = [&](uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    if (same(a, c) || same(a, d) || same(b, c) || same(b, d)) return false;
+    return ((cross(a, b, c) > 0) != (cross(a, b, d) > 0)) && ((cross(c, d, a) > 0) != (cross(c, d, b) > 0));
+  };
+
+  // join the holes to the exterior ring, starting with the hole that reaches furthest in the u direction
+  std::vector<std::vector<uint32_t>> holes;
+  for (size_t r=1; r<rings.size(); ++r)
+  {
+    auto& hole = rings[r];
+    if (hole.size() < 3) continue;
+    // the holes must have the opposite orientation of the exterior ring
+    double area = 0;
+    for (size_t i=1; i+1<hole.size(); ++i) area += cross(hole[0], hole[i], hole[i+1]);
+    if (area > 0) std::reverse(hole.begin(), hole.end());
+    // put the vertex with the largest u first
+    auto max_u = std::max_element(hole.begin(), hole.end(), [&](uint32_t a, uint32_t b) { 
+      return vertices[a][u] < vertices[b][u]; 
+    });
+    std::rotate(hole.begin(), max_u, hole.end());
+    holes.push_back(std::move(hole));
+  }
+  std::sort(holes.begin(), holes.end(), [&](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    return vertices[a[0]][u] > vertices[b[0]][u];
+  });
+  std::vector<uint32_t> remaining = std::move(exterior);
+  for (size_t k=0; k<holes.size(); ++k)
+  {
+    auto& hole = holes[k];
+    uint32_t h = hole[0];
+    // a ring vertex that can be connected to h without crossing any ring, the closest one if there are several
+    auto visible = [&](uint32_t o) {
+      for (size_t i=0; i<remaining.size(); ++i)
+        if (crosses(h, o, remaining[i], remaining[(i+1)%remaining.size()])) return false;
+      for (size_t j=k; j<holes.size(); ++j)
+        for (size_t i=0; i<holes[j].size(); ++i)
+          if (crosses(h, o, holes[j][i], holes[j][(i+1)%holes[j].size()])) return false;
+      return true;
+    };
+    auto distance = [&](uint32_t o) {
+      double du = double(vertices[o][u]) - vertices[h][u], dv = double(vertices[o][v]) - vertices[h][v];
+      return du*du + dv*dv;
+    };
+    size_t bridge = remaining.size();
+    for (size_t i=0; i<remaining.size(); ++i)
+    {
+      if (!visible(remaining[i])) continue;
+      if (bridge == remaining.size() || distance(remaining[i]) < distance(remaining[bridge])) bridge = i;
+    }
+    // no visible vertex in a degenerate polygon, use the closest one
+    if (bridge == remaining.size())
+    {
+      bridge = 0;
+      for (size_t i=1; i<remaining.size(); ++i)
+        if (distance(remaining[i]) < distance(remaining[bridge])) bridge = i;
+    }
+    // ring up to the bridge vertex, around the hole and back over the bridge
+    std::vector<uint32_t> joined(remaining.begin(), remaining.begin()+bridge+1);
+    joined.insert(joined.end(), hole.begin(), hole.end());
+    joined.push_back(h);
+    joined.insert(joined.end(), remaining.begin()+bridge, remaining.end());
+    remaining = std::move(joined);
+  }
+
+  size_t i = 0, n_failed = 0;
+  while (remaining.size() > 3)
+  {
+    size_t m = remaining.size();
+    uint32_t a = remaining[(i+m-1)%m], b = remaining[i%m], c = remaining[(i+1)%m];
+    bool is_ear = cross(a, b, c) > 0;
+    for (size_t j=0; is_ear && j<m; ++j)
+    {
+      auto p = remaining[j];
+      if (same(p, a) || same(p, b) || same(p, c)) continue;
+      is_ear = !inside(p, a, b, c);
+    }
+    if (is_ear)
+    {
+      result.insert(result.end(), {a, b, c});
+      remaining.erase(remaining.begin() + i%m);
+      n_failed = 0;
+    }
+    else if (++n_failed == m)
+    {
+      // no ear left, the ring is degenerate or self-intersecting. Fall back to a fan of the remaining vertices
+      for (size_t j=1; j+1<m; ++j)
+        result.insert(result.end(), {remaining[0], remaining[j], remaining[j+1]});
+      return;
+    }
+    else
+    {
+      ++i;
+    }
+  }
+  result.insert(result.end(), remaining.begin(), remaining.end());
+}
+
+std::vector<uint32_t> IndexedMesh::triangle_indices() const
+{
+  if (is_triangle_mesh()) return indices_;
+  std::vector<uint32_t> result;
+  for (size_t p=0; p<polygon_count(); ++p)
+  {
+    std::vector<std::vector<uint32_t>> rings;
+    for (auto r=polygon_offsets_[p]; r<polygon_offsets_[p+1]; ++r)
+      rings.emplace_back(indices_.begin() + ring_offsets_[r], indices_.begin() + ring_offsets_[r+1]);
+    triangulate_polygon(vertices_, std::move(rings), result);
+  }
+  return result;
+}
+TriangleCollection IndexedMesh::to_triangle_collection() const
+{
+  TriangleCollection triangles;
+  triangles.set_offset(offset_);
+  auto tri_indices = triangle_indices();
+  triangles.reserve(tri_indices.size() / 3);
+  for (size_t i=0; i+2<tri_indices.size(); i+=3)
+    triangles.push_back({vertices_[tri_indices[i]], vertices_[tri_indices[i+1]], vertices_[tri_indices[i+2]]});
+  return triangles;
+}
+Mesh IndexedMesh::to_mesh() const
+{
+  Mesh mesh;
+  auto get_ring = [this](uint32_t r, vec3f& ring) {
+    for (auto i=ring_offsets_[r]; i<ring_offsets_[r+1]; ++i)
+      ring.push_back(vertices_[indices_[i]]);
+  };
+  for (size_t p=0; p<polygon_count(); ++p)
+  {
+    LinearRing polygon;
+    polygon.set_offset(offset_);
+    get_ring(polygon_offsets_[p], polygon);
+    for (auto r=polygon_offsets_[p]+1; r<polygon_offsets_[p+1]; ++r)
+    {
+      polygon.interior_rings().emplace_back();
+      get_ring(r, polygon.interior_rings().back());
+    }
+    mesh.push_polygon(polygon, labels_[p]);
+  }
+  return mesh;
+}
+size_t IndexedMesh::vertex_count() const
+{
+  return vertices_.size();
+}
+void IndexedMesh::compute_box()
+{
+  if (!bbox.has_value())
+  {
+    bbox = Box();
+    bbox->add(vertices_);
+  }
+}
+float *IndexedMesh::get_data_ptr()
+{
+  if (vertices_.empty()) return nullptr;
+  return vertices_[0].data();
+}
+
 } // namespace geoflow
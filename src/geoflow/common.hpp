@@ -17,6 +17,8 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <optional>
 #include <unordered_map>
@@ -31,7 +33,9 @@ namespace geoflow
 
 typedef std::array<float, 2> arr2f;
 typedef std::array<float, 3> arr3f;
+typedef std::array<double, 3> arr3d;
 typedef std::vector<arr3f> vec3f;
+typedef std::vector<arr3d> vec3d;
 typedef std::vector<std::array<float, 2>> vec2f;
 typedef std::vector<int> vec1i;
 typedef std::vector<bool> vec1b;
@@ -43,6 +47,92 @@ typedef std::vector<std::string> vec1s;
 typedef std::variant<bool, int, std:: string, float> attribute_value;
 typedef std::unordered_map<std::string, std::vector<attribute_value>> AttributeMap;
 
+// the types of attribute_value, in the same order as the alternatives of the variant
+enum AttributeType {
+  AttributeTypeBool,
+  AttributeTypeInt,
+  AttributeTypeString,
+  AttributeTypeFloat
+};
+
+// A column of an AttributeTable. The values are stored in one contiguous array of the column type, strings are 
+// dictionary encoded, ie. the column stores for each value an index into dictionary(). Missing values are marked 
+// in a null bitmap. Columns share their data when they are copied or sliced, the data is only copied when a shared 
+// column is modified.
+class AttributeColumn
+{
+  struct Data {
+    AttributeType type;
+    std::vector<uint8_t> bools;
+    vec1i ints;
+    vec1f floats;
+    std::vector<uint32_t> codes;
+    vec1s dictionary;
+    std::unordered_map<std::string, uint32_t> dictionary_index;
+    // bit i is set if value i is not null, empty if there are no nulls
+    std::vector<uint64_t> valid;
+    size_t size = 0;
+  };
+  std::shared_ptr<Data> data_;
+  size_t begin_ = 0, size_ = 0;
+
+  // make this column the only owner of its data and let it view all of the data
+  void detach();
+
+public:
+  AttributeColumn(AttributeType type);
+
+  AttributeType type() const;
+  size_t size() const;
+  bool is_null(size_t i) const;
+  bool has_nulls() const;
+  // throws std::invalid_argument if the type of value does not match the column type
+  void push_back(const attribute_value& value);
+  void push_null();
+  // returns no value for nulls
+  std::optional<attribute_value> get(size_t i) const;
+
+  // the contiguous values of the column type, the string column returns the dictionary codes in codes(). Values 
+  // that are null have an unspecified value
+  const uint8_t* bools() const;
+  const int* ints() const;
+  const float* floats() const;
+  const uint32_t* codes() const;
+  const vec1s& dictionary() const;
+
+  // returns a column that views n values starting at begin, without copying them
+  AttributeColumn slice(size_t begin, size_t n) const;
+};
+
+// AttributeTable stores attributes column by column in AttributeColumns, each column has one value per row (ie. 
+// per feature). Slicing a table shares the data of the columns, eg. to hand the attributes of a range of features 
+// to another node without copying them.
+class AttributeTable
+{
+  std::vector<std::pair<std::string, AttributeColumn>> columns_;
+
+public:
+  AttributeTable() = default;
+  // the type of each column is taken from its first value, nulls are not possible in an AttributeMap
+  AttributeTable(const AttributeMap& attributes);
+
+  size_t size() const;
+  size_t column_count() const;
+  bool has_column(const std::string& name) const;
+  // adds a column that is filled with nulls up to size(), or returns the existing column with this name
+  AttributeColumn& add_column(const std::string& name, AttributeType type);
+  // adds or replaces a column, the data of the column is shared with the given column
+  AttributeColumn& add_column(const std::string& name, const AttributeColumn& column);
+  AttributeColumn& column(const std::string& name);
+  const AttributeColumn& column(const std::string& name) const;
+  // in the order the columns were added
+  vec1s column_names() const;
+
+  AttributeTable slice(size_t begin, size_t n) const;
+  // nulls are replaced by the default value of the column type
+  AttributeMap to_attribute_map() const;
+};
+
 class Box
 {
 private:
@@ -68,19 +158,41 @@ public:
   arr3f center() const;
 };
 
+// Geometries store float coordinates relative to a double precision offset, ie. the absolute coordinates of a
+// vertex are offset() + its stored coordinates. This keeps the precision of eg. national grid coordinates that
+// can not be represented exactly by a float.
 class Geometry
 {
 protected:
   std::optional<Box> bbox;
+  arr3d offset_ = {0, 0, 0};
   virtual void compute_box() = 0;
+  // adds d to every stored vertex. The default implementation assumes that get_data_ptr() points to
+  // vertex_count() contiguous vertices
+  virtual void translate_vertices(const arr3d& d);
 
 public:
   virtual size_t vertex_count() const = 0;
   virtual const Box &box();
   size_t dimension();
+  // pointer to the vertex_count() stored vertices as contiguous x,y,z triplets, writes through it modify the
+  // geometry. Geometries that do not store their vertices that way (eg. PointCloud) return nullptr
   virtual float *get_data_ptr() = 0;
+
+  const arr3d& offset() const;
+  // sets the offset without changing the stored coordinates
+  void set_offset(const arr3d& offset);
+  // sets the offset and translates the stored coordinates so that the absolute coordinates stay the same
+  void rebase(const arr3d& offset);
+  // convert a single vertex between absolute and stored coordinates, eg. in reader and writer nodes
+  arr3f to_local(const arr3d& p) const;
+  arr3d to_global(const arr3f& p) const;
 };
 
+// convert a batch of vertices between absolute coordinates and float coordinates relative to offset
+vec3f to_local(const vec3d& points, const arr3d& offset);
+vec3d to_global(const vec3f& points, const arr3d& offset);
+
 // geometry types:
 // typedef arr3f Point;
 typedef std::array<arr3f, 3> Triangle;
@@ -91,6 +203,7 @@ class LinearRing : public vec3f, public Geometry
   std::vector<vec3f> interior_rings_;
 protected:
   void compute_box();
+  void translate_vertices(const arr3d& d);
 
 public:
   size_t vertex_count() const;
@@ -166,6 +279,9 @@ public:
   size_t attr_size() const;
   bool has_attributes();
   bool has_attributes() const;
+  // the attributes in columnar form, with one row per TriangleCollection. Only the first value of each attribute of a 
+  // TriangleCollection is used, missing attributes are null
+  AttributeTable get_attribute_table() const;
 };
 
 class SegmentCollection : public GeometryCollection<std::array<arr3f, 2>>
@@ -184,8 +300,64 @@ public:
   float *get_data_ptr();
 };
 
+// PointCloud stores points as a structure of arrays, ie. one contiguous column for each of the x, y and z
+// coordinates and optionally one float column per point attribute. The attribute columns always have the same
+// length as the coordinate columns. Unlike PointCollection the box, translate and filter functions process
+// the columns with SIMD kernels. Notice that the box is cached, modifying the columns directly through x(), y()
+// or z() does not reset it.
+class PointCloud : public Geometry
+{
+  vec1f x_, y_, z_;
+  std::unordered_map<std::string, vec1f> attributes_;
+
+protected:
+  void compute_box();
+  void translate_vertices(const arr3d& d);
+
+public:
+  PointCloud() = default;
+  PointCloud(const PointCollection& points);
+
+  size_t size() const;
+  bool empty() const;
+  void reserve(size_t n);
+  void resize(size_t n);
+  void clear();
+  void push_back(const arr3f& p);
+  arr3f operator[](size_t i) const;
+
+  vec1f& x();
+  vec1f& y();
+  vec1f& z();
+  const vec1f& x() const;
+  const vec1f& y() const;
+  const vec1f& z() const;
+
+  // adds an attribute column that is initialised with zeros, or returns the existing column with this name
+  vec1f& add_attribute(const std::string& name);
+  bool has_attribute(const std::string& name) const;
+  vec1f& attribute(const std::string& name);
+  const vec1f& attribute(const std::string& name) const;
+  std::unordered_map<std::string, vec1f>& attributes();
+  const std::unordered_map<std::string, vec1f>& attributes() const;
+
+  // adds offset to all points, eg. pass the negated NodeManager::data_offset to move them to local coordinates
+  void translate(const std::array<double, 3>& offset);
+  // returns the points (and their attributes) that are inside box, the z coordinate is ignored unless use_z is set
+  PointCloud filter(const Box& box, bool use_z = false) const;
+
+  PointCollection to_point_collection() const;
+
+  size_t vertex_count() const;
+  // returns nullptr, the coordinates are only available as the separate columns x(), y() and z()
+  float *get_data_ptr();
+};
+
 class LineStringCollection : public GeometryCollection<vec3f>
 {
+protected:
+  void translate_vertices(const arr3d& d);
+
 public:
   size_t vertex_count() const;
   void compute_box();
@@ -194,12 +366,70 @@ public:
 
 class LinearRingCollection : public GeometryCollection<vec3f>
 {
+protected:
+  void translate_vertices(const arr3d& d);
+
 public:
   size_t vertex_count() const;
   void compute_box();
   float *get_data_ptr();
 };
 
+// PackedRingCollection stores the vertices of all its rings (or linestrings) in a single contiguous array, ring i 
+// consists of the vertices [offsets()[i], offsets()[i+1]). Compared to LineStringCollection and 
+// LinearRingCollection this needs only one allocation for all rings, and get_data_ptr() returns all vertices.
+class PackedRingCollection : public Geometry
+{
+  vec3f vertices_;
+  std::vector<size_t> offsets_;
+
+protected:
+  void compute_box();
+
+public:
+  PackedRingCollection();
+  PackedRingCollection(const std::vector<vec3f>& rings);
+
+  size_t size() const;
+  bool empty() const;
+  void reserve(size_t ring_count, size_t vertex_count);
+  void clear();
+  void push_back(const vec3f& ring);
+  // build a ring vertex by vertex, eg. in a reader. end_ring() closes the current ring
+  void add_vertex(const arr3f& p);
+  void end_ring();
+
+  size_t ring_size(size_t i) const;
+  arr3f* ring_data(size_t i);
+  const arr3f* ring_data(size_t i) const;
+  vec3f ring(size_t i) const;
+  std::vector<vec3f> unpack() const;
+
+  vec3f& vertices();
+  const vec3f& vertices() const;
+  std::vector<size_t>& offsets();
+  const std::vector<size_t>& offsets() const;
+
+  size_t vertex_count() const;
+  float *get_data_ptr();
+};
+
+class PackedLineStringCollection : public PackedRingCollection
+{
+public:
+  using PackedRingCollection::PackedRingCollection;
+  PackedLineStringCollection(const LineStringCollection& linestrings);
+  LineStringCollection to_collection() const;
+};
+
+class PackedLinearRingCollection : public PackedRingCollection
+{
+public:
+  using PackedRingCollection::PackedRingCollection;
+  PackedLinearRingCollection(const LinearRingCollection& rings);
+  LinearRingCollection to_collection() const;
+};
+
 
 // struct AttributeVec {
 //   AttributeVec(std::type_index ttype) : value_type(ttype) {};
@@ -231,6 +461,62 @@ class Mesh {
   // const std::unordered_map<std::string, AttributeVec>&  get_attributes() const;
 };
 
+// IndexedMesh stores every vertex once in a single vertex buffer, the polygons refer to their vertices by index. 
+// The polygons are stored in compressed sparse row form: polygon p consists of the rings 
+// [polygon_offsets()[p], polygon_offsets()[p+1]), the first of which is its exterior ring, and ring r consists of the 
+// vertices indices()[ring_offsets()[r]] up to indices()[ring_offsets()[r+1]]. For a triangle mesh the indices can 
+// be passed to an OpenGL index buffer directly.
+class IndexedMesh : public Geometry
+{
+  vec3f vertices_;
+  std::vector<uint32_t> indices_;
+  std::vector<uint32_t> ring_offsets_;
+  std::vector<uint32_t> polygon_offsets_;
+  std::vector<int> labels_;
+
+protected:
+  void compute_box();
+
+public:
+  IndexedMesh();
+  // these constructors merge vertices with exactly the same coordinates. The mesh gets the offset of the first polygon, 
+  // the vertices of polygons with another offset are moved onto it
+  IndexedMesh(const TriangleCollection& triangles);
+  IndexedMesh(const Mesh& mesh);
+
+  // adds a vertex and returns its index, the vertex is not merged with existing vertices
+  uint32_t add_vertex(const arr3f& p);
+  void add_polygon(const std::vector<uint32_t>& exterior, const std::vector<std::vector<uint32_t>>& interior = {}, int label = 0);
+  void add_triangle(uint32_t a, uint32_t b, uint32_t c, int label = 0);
+  void clear();
+
+  size_t polygon_count() const;
+  size_t ring_count() const;
+  // true if every polygon consists of a single ring with 3 vertices
+  bool is_triangle_mesh() const;
+
+  vec3f& vertices();
+  const vec3f& vertices() const;
+  std::vector<uint32_t>& indices();
+  const std::vector<uint32_t>& indices() const;
+  std::vector<uint32_t>& ring_offsets();
+  const std::vector<uint32_t>& ring_offsets() const;
+  std::vector<uint32_t>& polygon_offsets();
+  const std::vector<uint32_t>& polygon_offsets() const;
+  // one label per polygon
+  std::vector<int>& labels();
+  const std::vector<int>& labels() const;
+
+  // returns 3 vertex indices per triangle. Polygons that are not triangles are triangulated by ear clipping, which 
+  // handles concave polygons. Interior rings are joined to the exterior ring by a bridge edge before ear clipping
+  std::vector<uint32_t> triangle_indices() const;
+  TriangleCollection to_triangle_collection() const;
+  Mesh to_mesh() const;
+
+  size_t vertex_count() const;
+  float *get_data_ptr();
+};
+
 // modelled after https://gdal.org/api/ogrfeature_cpp.html#_CPPv4NK10OGRFeature18GetFieldAsDateTimeEiPiPiPiPiPiPiPi
 struct Date {
   int year;
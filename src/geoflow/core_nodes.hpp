@@ -6,7 +6,12 @@
 
 #include <chrono>
 #include <ctime>
-// #include <taskflow/taskflow.hpp>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <algorithm>
+#include <taskflow/taskflow.hpp>
 
 namespace geoflow::nodes::core {
 
@@ -21,12 +26,26 @@ namespace geoflow::nodes::core {
     private:
     bool flowchart_loaded=false;
     bool use_parallel_processing=false;
+    bool use_pipelining=false;
+    int n_threads_=0;
+    int items_in_flight_=4;
     std::string filepath_;
     std::unique_ptr<NodeManager> nested_node_manager_;
     // std::vector<std::weak_ptr<gfInputTerminal>> nested_inputs_;
     // std::vector<std::weak_ptr<gfOutputTerminal>> nested_outputs_;
     std::string proxy_node_name_ = "ProxyNode";
     size_t input_size_=0;
+    // thread pool for parallel and pipelined processing, kept between calls of process()
+    std::unique_ptr<tf::Executor> executor_;
+
+    size_t get_thread_count() const {
+      return n_threads_ > 0 ? n_threads_ : std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    tf::Executor& get_executor() {
+      if (!executor_ || executor_->num_workers() != get_thread_count())
+        executor_ = std::make_unique<tf::Executor>(get_thread_count());
+      return *executor_;
+    }
 
     bool load_nodes() {
       if (fs::exists(filepath_)) {
@@ -76,6 +95,9 @@ namespace geoflow::nodes::core {
       nested_node_manager_ = std::make_unique<NodeManager>(manager.get_node_registers()); // this will only transfer the node registers
       add_param(ParamPath(filepath_, "filepath", "Flowchart file"));
       add_param(ParamBool(use_parallel_processing, "use_parallel_processing", "Use parallel processing"));
+      add_param(ParamInt(n_threads_, "n_threads", "Number of worker threads for parallel processing (0 = all cores)"));
+      add_param(ParamBool(use_pipelining, "use_pipelining", "Process the items in a pipeline, every node of the nested flowchart works on a different item"));
+      add_param(ParamInt(items_in_flight_, "items_in_flight", "Maximum number of items in the pipeline at the same time"));
 
     };
     void post_parameter_load() {
@@ -102,9 +124,30 @@ namespace geoflow::nodes::core {
       };
     #endif
 
-    std::shared_ptr<NodeManager> copy_nested_flowchart() {
-      auto flowchart = std::make_shared<NodeManager>(*nested_node_manager_);
-      flowchart->data_offset = *manager.data_offset;
+    // a copy of the nested flowchart, with the wiring between this node and the proxy node resolved once
+    struct NestedFlowchart {
+      std::shared_ptr<NodeManager> flowchart;
+      // the GF_I global, updated for every item
+      std::shared_ptr<ParameterByValue<std::string>> item_index;
+      // inputs of this node and the proxy outputs they feed
+      std::vector<std::pair<gfSingleFeatureInputTerminal*, gfSingleFeatureOutputTerminal*>> vector_inputs;
+      // sub terminals of the poly inputs of this node and the proxy sub outputs they feed
+      std::vector<std::pair<const gfSingleFeatureOutputTerminal*, gfSingleFeatureOutputTerminal*>> poly_inputs;
+      // nodes that are connected to the proxy, their results are cleared before each item
+      std::set<NodeHandle> proxy_children;
+      // marked outputs of the nested flowchart by name
+      std::vector<std::pair<std::string, gfOutputTerminal*>> outputs;
+    };
+
+    NestedFlowchart copy_nested_flowchart() {
+      NestedFlowchart nested;
+      auto flowchart = nested.flowchart = std::make_shared<NodeManager>(*nested_node_manager_);
+      flowchart->share_data_offset(manager);
+      for (auto& [key,val] : manager.global_flowchart_params) {
+        flowchart->global_flowchart_params[key] = val;
+      }
+      nested.item_index = std::make_shared<ParameterByValue<std::string>>("", "GF_I", "");
+      flowchart->global_flowchart_params["GF_I"] = nested.item_index;
       // set up proxy node
       auto R = std::make_shared<NodeRegister>("ProxyRegister");
       R->register_node<ProxyNode>("Proxy");
@@ -118,119 +161,323 @@ namespace geoflow::nodes::core {
               auto input_name = node_name+"."+input_term->get_name();
               if(input_term->get_family() == GF_SINGLE_FEATURE) {
                 proxy_node->add_output(input_name, input_term->get_types());
-                proxy_node->output(input_name).connect(*input_term);
+                auto& proxy_output = proxy_node->output(input_name);
+                proxy_output.connect(*input_term);
+                // we need to set the correct type
+                proxy_output.set_type(vector_input(input_name).get_connected_type());
+                nested.vector_inputs.push_back({&vector_input(input_name), &proxy_output});
               } else { // GF_MULTI_FEATURE
                 proxy_node->add_poly_output(input_name, input_term->get_types());
-                auto mf_oterm = proxy_node->poly_output(input_name);
-                proxy_node->poly_output(input_name).connect(*input_term);
+                auto& proxy_output = proxy_node->poly_output(input_name);
+                proxy_output.connect(*input_term);
+                for (auto sub_iterm : poly_input(input_name).sub_terminals()) {
+                  auto& sub_oterm = proxy_output.add(sub_iterm->get_name(), sub_iterm->get_types()[0]);
+                  nested.poly_inputs.push_back({sub_iterm, &sub_oterm});
+                }
               }
             }
           }
+          for (auto& [name, output_term] : node->output_terminals) {
+            if (output_term->is_marked())
+              nested.outputs.push_back({node_name+"."+name, output_term.get()});
+          }
       }
+      nested.proxy_children = proxy_node->get_child_nodes();
 
-      return flowchart;
+      return nested;
+    }
+    // get_any() returns a copy of the element, which is moved into the proxy output
+    void set_inputs(NestedFlowchart& nested, size_t i) {
+      for (auto& [input, proxy_output] : nested.vector_inputs) {
+        proxy_output->set_from_any(input->get_any(i));
+      }
+      for (auto& [sub_iterm, sub_oterm] : nested.poly_inputs) {
+        sub_oterm->set_from_any(sub_iterm->get_any(i));
+      }
     }
-    void set_inputs(std::shared_ptr<NodeManager>& flowchart, size_t i) {
-      auto proxy_node = flowchart->get_node(proxy_node_name_);
-      // note that proxy node has no inputs
-      
-      for(auto& [name, proxy_output] : proxy_node->output_terminals) {
-        if (proxy_output->get_family()==GF_SINGLE_FEATURE) {
-          auto& data_vec = vector_input(name).get_data_vec();
-          // we need to set the correct type
-          proxy_node->output(name).set_type(vector_input(name).get_connected_type());
-          proxy_node->output(name).set_from_any(data_vec[i]);
+
+    // data of the marked outputs of the nested flowchart after processing one item
+    struct NestedOutputs {
+      std::map<std::string, std::vector<std::any>> vector_data;
+      // sub terminal name -> (type, data) for each poly output
+      std::map<std::string, std::map<std::string, std::pair<std::type_index, std::vector<std::any>>>> poly_data;
+    };
+
+    // clear the results of the previous item and set the inputs for item i
+    void prepare_item(NestedFlowchart& nested, size_t i) {
+      // the proxy outputs are overwritten, so only the nodes after the proxy need to be cleared
+      for (auto& child : nested.proxy_children) {
+        child->notify_children();
+      }
+      nested.item_index->set(std::to_string(i));
+      set_inputs(nested, i);
+      std::cout << "Processing item " << i+1 << "/" << input_size_ << "\n";
+    }
+
+    float run_item(NestedFlowchart& nested, size_t i) {
+      prepare_item(nested, i);
+      // run
+      auto t_start = std::chrono::steady_clock::now(); // Wall time
+      nested.flowchart->run_all(false);
+      auto t_end = std::chrono::steady_clock::now(); // Wall time
+      float runtime = std::chrono::duration<float, std::milli>(t_end-t_start).count();
+      std::cout << ".. " << runtime << "ms\n";
+      return runtime;
+    }
+
+    NestedOutputs collect_outputs(NestedFlowchart& nested, size_t i) {
+      NestedOutputs outputs;
+      for (auto& [output_name, output_term_] : nested.outputs) {
+        if (output_term_->get_family() == GF_SINGLE_FEATURE) {
+          auto output_term = (gfSingleFeatureOutputTerminal*)(output_term_);
+          auto& data_vec = outputs.vector_data[output_name];
+          if (output_term->has_data()) {
+            for (size_t j=0; j<output_term->size(); ++j) {
+              data_vec.push_back(output_term->get_any(j));
+            }
+          } else {
+            std::cout << "pushing empty any for " << output_name << "at i=" << i << std::endl;
+            data_vec.push_back(std::any());
+          }
         } else {
-          for (auto sub_iterm : poly_input(name).sub_terminals()) {
-            auto& sub_name = sub_iterm->get_name();
-            // first add sub terminal
-            auto& sub_oterm = proxy_node->poly_output(name).add(sub_name, sub_iterm->get_types()[0]);
-            sub_oterm.set_from_any(sub_iterm->get_data_vec()[i]);
+          auto output_term = (gfMultiFeatureOutputTerminal*)(output_term_);
+          auto& poly_data = outputs.poly_data[output_name];
+          for (auto& [name, sub_term]: output_term->sub_terminals()) {
+            auto& sub_data = poly_data.emplace(name, std::make_pair(sub_term->get_type(), std::vector<std::any>())).first->second.second;
+            for (size_t j=0; j<sub_term->size(); ++j) {
+              sub_data.push_back(sub_term->get_any(j));
+            }
           }
         }
       }
+      return outputs;
+    }
+
+    // move the outputs of one item to the vector outputs of this node
+    void push_outputs(NestedOutputs&& outputs, float runtime) {
+      for (auto& [name, data_vec] : outputs.vector_data) {
+        auto& aggregate_out = vector_output(name);
+        for (auto& data : data_vec) {
+          aggregate_out.push_back_any(std::move(data));
+        }
+      }
+      for (auto& [name, sub_terms] : outputs.poly_data) {
+        auto& aggregate_poly_out = poly_output(name);
+        for (auto& [sub_name, sub_term] : sub_terms) {
+          if (!aggregate_poly_out.sub_terminals().count(sub_name)) {
+            aggregate_poly_out.add_vector(sub_name, sub_term.first);
+          }
+          auto& aggregate_sub_term = aggregate_poly_out.sub_terminal(sub_name);
+          for (auto& data : sub_term.second) {
+            aggregate_sub_term.push_back_any(std::move(data));
+          }
+          aggregate_sub_term.touch();
+        }
+        aggregate_poly_out.touch();
+      }
+      vector_output(get_name()+".timings").push_back(runtime);
+    }
+
+    // memory needed to process one item in a copy of the nested flowchart, 0 if unknown
+    size_t estimate_item_memory_kb(NodeManager& flowchart) {
+      size_t estimate_kb = 0;
+      for (auto& [name, node] : flowchart.get_nodes()) {
+        estimate_kb += node->estimate_memory_kb();
+      }
+      return estimate_kb;
+    }
+    // keep what a copy learned about the memory use of the nested nodes, for the next time this node is processed
+    void learn_memory_estimates(NestedFlowchart& nested) {
+      auto& nodes = nested_node_manager_->get_nodes();
+      for (auto& [name, node] : nested.flowchart->get_nodes()) {
+        auto it = nodes.find(name);
+        if (it != nodes.end())
+          it->second->memory_estimate_kb = std::max(it->second->memory_estimate_kb, node->memory_estimate_kb);
+      }
     }
 
     void process_parallel() {
+      if (input_size_ == 0) return;
       // repack input data
       // assume all vector inputs have the same size
+      size_t n_workers = std::min(get_thread_count(), input_size_);
+
+      // one flowchart instance per worker. These are created here, because node construction is not thread safe
+      std::vector<NestedFlowchart> flowcharts;
+      for(size_t k=0; k<n_workers; ++k) {
+        flowcharts.push_back(copy_nested_flowchart());
+      }
 
-      // std::vector<std::shared_ptr<NodeManager>> flowcharts;
-      // for(size_t i=0; i<input_size_; ++i) {
-      //   auto fc = copy_nested_flowchart();
-      //   for (auto& [key,val] : manager.global_flowchart_params) {
-      //     fc->global_flowchart_params[key] = val;
-      //   }
-      //   fc->global_flowchart_params["GF_I"] = std::make_shared<ParameterByValue<std::string>>(std::to_string(i), "GF_I", "");
-      //   set_inputs(fc, i);
-      //   flowcharts.push_back(fc);
-      // }
-
-      // tf::Executor executor;
-      // tf::Taskflow taskflow;
-      // for(auto& fc : flowcharts) {
-      //   tf::Task task = taskflow.emplace([&](){ 
-      //     auto& proxy_node = fc->get_node(proxy_node_name_);
-      //     fc->run(proxy_node, false);
-      //    });
-      // }
-      // executor.run(taskflow).wait();
+      // every worker keeps taking the next unprocessed item until all items are done. 
+      // Results are stored per item, so we can push them to the outputs in index order afterwards
+      std::vector<NestedOutputs> results(input_size_);
+      std::vector<float> runtimes(input_size_);
+      std::atomic<size_t> next_item{0};
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+      std::mutex error_mutex;
+
+      // With a memory budget, each item reserves the memory its flowchart copy needs instead of this node reserving for all 
+      // of them. As long as that is unknown an item reserves the whole budget, so the first item runs alone
+      manager.release_memory(reserved_memory_kb_);
+      reserved_memory_kb_ = 0;
+      std::atomic<size_t> item_estimate_kb{estimate_item_memory_kb(*flowcharts[0].flowchart)};
+
+      tf::Taskflow taskflow;
+      for(auto& fc : flowcharts) {
+        taskflow.emplace([&]() {
+          for (size_t i = next_item++; i < input_size_ && !failed; i = next_item++) {
+            size_t reserved_kb = manager.reserve_memory(item_estimate_kb ? item_estimate_kb.load() : manager.memory_budget_kb);
+            try {
+              runtimes[i] = run_item(fc, i);
+              results[i] = collect_outputs(fc, i);
+              // an item that used less than 1 kB still makes the estimate known
+              size_t estimate_kb = std::max<size_t>(1, estimate_item_memory_kb(*fc.flowchart));
+              size_t current_kb = item_estimate_kb;
+              while (estimate_kb > current_kb && !item_estimate_kb.compare_exchange_weak(current_kb, estimate_kb));
+            } catch (...) {
+              std::lock_guard<std::mutex> lock(error_mutex);
+              if (!failed) error = std::current_exception();
+              failed = true;
+            }
+            manager.release_memory(reserved_kb);
+          }
+        });
+      }
+      get_executor().run(taskflow).wait();
+      for (auto& fc : flowcharts) {
+        learn_memory_estimates(fc);
+      }
+      if (error) std::rethrow_exception(error);
+
+      for(size_t i=0; i<input_size_; ++i) {
+        push_outputs(std::move(results[i]), runtimes[i]);
+      }
+    };
+
+    // nodes of the nested flowchart in topological order, without the proxy node
+    std::vector<std::string> get_stages(NodeManager& flowchart) {
+      std::vector<std::string> stages;
+      for (auto node : flowchart.get_execution_plan()->nodes) {
+        if (node->get_name() != proxy_node_name_)
+          stages.push_back(node->get_name());
+      }
+      return stages;
+    }
+
+    // Every node of the nested flowchart is a stage that processes the items one after another, in order. Different stages work on different
+    // items at the same time, so eg. reading the next item overlaps with processing the current one. Each item in flight has its own copy of
+    // the nested flowchart, an item can only enter the pipeline once the copy of the item that is items_in_flight places earlier is collected.
+    void process_pipelined() {
+      if (input_size_ == 0) return;
+      size_t n_slots = std::min(size_t(std::max(items_in_flight_, 1)), input_size_);
+      // with a memory budget, only as many items are in flight as fit in it
+      size_t item_estimate_kb = estimate_item_memory_kb(*nested_node_manager_);
+      if (manager.memory_budget_kb && item_estimate_kb)
+        n_slots = std::max(size_t(1), std::min(n_slots, manager.memory_budget_kb / item_estimate_kb));
+
+      std::vector<NestedFlowchart> flowcharts;
+      for(size_t k=0; k<n_slots; ++k) {
+        flowcharts.push_back(copy_nested_flowchart());
+      }
+      auto stages = get_stages(*flowcharts[0].flowchart);
+      // child stages of each stage, by index in stages
+      std::vector<std::vector<size_t>> stage_children(stages.size());
+      for (size_t s=0; s<stages.size(); ++s) {
+        for (auto& child : flowcharts[0].flowchart->get_node(stages[s])->get_child_nodes()) {
+          auto it = std::find(stages.begin(), stages.end(), child->get_name());
+          if (it != stages.end()) stage_children[s].push_back(it - stages.begin());
+        }
+      }
+
+      std::vector<NestedOutputs> results(input_size_);
+      std::vector<float> runtimes(input_size_);
+      std::vector<std::chrono::steady_clock::time_point> start_times(input_size_);
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+      std::mutex error_mutex;
+      auto guarded = [&](auto f) {
+        return [&, f]() {
+          if (failed) return;
+          try {
+            f();
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!failed) error = std::current_exception();
+            failed = true;
+          }
+        };
+      };
+
+      auto& executor = get_executor();
+      // the task graph is built for a window of items at a time to limit its size, the pipeline drains at the end of each window
+      size_t window_size = n_slots * 16;
+      for (size_t w0=0; w0<input_size_ && !failed; w0+=window_size) {
+        size_t w1 = std::min(w0+window_size, input_size_);
+        tf::Taskflow taskflow;
+        std::vector<tf::Task> collect_tasks;
+        std::vector<std::vector<tf::Task>> stage_tasks;
+        for (size_t i=w0; i<w1; ++i) {
+          auto& fc = flowcharts[i % n_slots];
+          auto prepare = taskflow.emplace(guarded([&, i]() {
+            start_times[i] = std::chrono::steady_clock::now();
+            prepare_item(fc, i);
+            // the proxy is not a stage, so let its children know about the new inputs here
+            fc.flowchart->get_node(proxy_node_name_)->propagate_outputs();
+          }));
+          auto collect = taskflow.emplace(guarded([&, i]() {
+            results[i] = collect_outputs(fc, i);
+            runtimes[i] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start_times[i]).count();
+          }));
+          std::vector<tf::Task> tasks;
+          for (auto& stage : stages) {
+            auto node = fc.flowchart->get_node(stage).get();
+            auto task = taskflow.emplace(guarded([&fc, node]() { fc.flowchart->run_single(*node); }));
+            prepare.precede(task);
+            task.precede(collect);
+            tasks.push_back(task);
+          }
+          for (size_t s=0; s<stages.size(); ++s) {
+            for (auto c : stage_children[s]) {
+              tasks[s].precede(tasks[c]);
+            }
+          }
+          size_t k = i-w0;
+          // every stage handles the items in order
+          if (k > 0) {
+            for (size_t s=0; s<stages.size(); ++s) {
+              stage_tasks[k-1][s].precede(tasks[s]);
+            }
+          }
+          // wait until the previous item in this flowchart copy is collected
+          if (k >= n_slots) {
+            collect_tasks[k-n_slots].precede(prepare);
+          }
+          collect_tasks.push_back(collect);
+          stage_tasks.push_back(std::move(tasks));
+        }
+        executor.run(taskflow).wait();
+      }
+      for (auto& fc : flowcharts) {
+        learn_memory_estimates(fc);
+      }
+      if (error) std::rethrow_exception(error);
+
+      for(size_t i=0; i<input_size_; ++i) {
+        push_outputs(std::move(results[i]), runtimes[i]);
+      }
     };
 
     void process_sequential() {
       // repack input data
       // assume all vector inputs have the same size
       auto flowchart = copy_nested_flowchart();
-      auto& proxy_node = flowchart->get_node(proxy_node_name_);
-      float runtime;
       for(size_t i=0; i<input_size_; ++i) {
-        proxy_node->notify_children();
-        // prep inputs
-        for (auto& [key,val] : manager.global_flowchart_params) {
-          flowchart->global_flowchart_params[key] = val;
-        }
-        flowchart->global_flowchart_params["GF_I"] = std::make_shared<ParameterByValue<std::string>>(std::to_string(i), "GF_I", "");
-        set_inputs(flowchart, i);
-        // run
-        std::cout << "Processing item " << i+1 << "/" << input_size_ << "\n";
-        std::clock_t c_start = std::clock(); // CPU time
-        // auto t_start = std::chrono::high_resolution_clock::now(); // Wall time
-        flowchart->run_all(false);
-        std::clock_t c_end = std::clock(); // CPU time
-        // auto t_end = std::chrono::high_resolution_clock::now(); // Wall time
-        runtime = 1000.0 * (c_end-c_start) / CLOCKS_PER_SEC;
-        std::cout << ".. " << runtime << "ms\n";
+        float runtime = run_item(flowchart, i);
         // collect outputs and push directly to vector outputs
-        for (auto& [node_name, node] : flowchart->get_nodes()) {
-          for (auto& [term_name, output_term_] : node->output_terminals) {
-            if (output_term_->is_marked()) {
-              if (output_term_->get_family() == GF_SINGLE_FEATURE) {
-                auto output_term = (gfSingleFeatureOutputTerminal*)(output_term_.get());
-                if (output_term->has_data()) {
-                  for (auto& data : output_term->get_data_vec()) {
-                    vector_output(node_name+"."+term_name).push_back_any(data);
-                  }
-                } else {
-                  std::cout << "pushing empty any for " << node_name+"."+term_name << "at i=" << i << std::endl;
-                  vector_output(node_name+"."+term_name).push_back_any(std::any());
-                }
-              } else {
-                auto output_term = (gfMultiFeatureOutputTerminal*)(output_term_.get());
-                auto& aggregate_poly_out = poly_output(node_name+"."+term_name);
-                for (auto& [name, sub_term]: output_term->sub_terminals()) {
-                  if(i==0) {
-                    aggregate_poly_out.add_vector(name, sub_term->get_type());
-                  }
-                  for (auto& data : sub_term->get_data_vec()) {
-                    aggregate_poly_out.sub_terminal(name).push_back_any(data);
-                  }
-                }
-              }
-            }
-          }
-        }
-        vector_output(get_name()+".timings").push_back(runtime);
+        push_outputs(collect_outputs(flowchart, i), runtime);
       }
+      learn_memory_estimates(flowchart);
     };
 
     void process() {
@@ -238,7 +485,9 @@ namespace geoflow::nodes::core {
         auto first_input = input_terminals.begin()->second.get();
         input_size_ = first_input->size();
         std::cout << "Begin processing for NestNode " << get_name() << "\n";
-        if (use_parallel_processing) {
+        if (use_pipelining) {
+          process_pipelined();
+        } else if (use_parallel_processing) {
           process_parallel();
         } else {
           process_sequential();
@@ -20,11 +20,110 @@
 #include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+#if defined(__cplusplus) && __cplusplus >= 201703L && defined(__has_include)
+  #if __has_include(<filesystem>)
+    #define GHC_USE_STD_FS
+    #include <filesystem>
+    namespace fs = std::filesystem;
+  #endif
+#endif
+#ifndef GHC_USE_STD_FS
+  #include <ghc/filesystem.hpp>
+  namespace fs = ghc::filesystem;
+#endif
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <time.h>
+  #include <sys/resource.h>
+#endif
+
+#include <taskflow/taskflow.hpp>
 
 #include "geoflow.hpp"
+#include "serialisation.hpp"
 
 using namespace geoflow;
 
+static void hash_combine(size_t& seed, size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed<<6) + (seed>>2);
+}
+
+// 64 bit FNV-1a hash, unlike std::hash this is stable between runs and platforms
+static uint64_t fnv1a_hash(const std::string& text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// part of the cache key of a node, bump when the serialisation of the outputs changes to invalidate existing cache files
+static const int cache_format_version = 2;
+
+// CPU time used by the calling thread
+static double thread_cpu_time_ms() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    return 0;
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernel_time.dwLowDateTime;
+  kernel.HighPart = kernel_time.dwHighDateTime;
+  user.LowPart = user_time.dwLowDateTime;
+  user.HighPart = user_time.dwHighDateTime;
+  // in units of 100ns
+  return (kernel.QuadPart + user.QuadPart) / 1e4;
+#else
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0;
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+// peak resident set size of this process so far
+static long peak_rss_kb() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return 0;
+  return long(pmc.PeakWorkingSetSize / 1024);
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  #ifdef __APPLE__
+    // bytes on macOS
+    return usage.ru_maxrss / 1024;
+  #else
+    return usage.ru_maxrss;
+  #endif
+#endif
+}
+static size_t output_data_bytes(gfOutputTerminal& oT) {
+  if (oT.get_family() == GF_SINGLE_FEATURE)
+    return static_cast<gfSingleFeatureOutputTerminal&>(oT).get_data_bytes();
+  size_t n_bytes = 0;
+  for (auto& [name, sub_term] : static_cast<gfMultiFeatureOutputTerminal&>(oT).sub_terminals()) {
+    n_bytes += sub_term->get_data_bytes();
+  }
+  return n_bytes;
+}
+
+// note on data that was copied out of input terminals during the last run of node n, see Node::get_copied_bytes()
+static std::string copied_bytes_note(const Node& n) {
+  if (n.get_copied_bytes() == 0) return "";
+  return " (copied at least " + std::to_string(n.get_copied_bytes()) + " bytes from input terminals)";
+}
+
 std::string random_string(size_t length) {
   auto randchar = []() -> char {
     const char charset[] =
@@ -47,75 +146,114 @@ bool gfTerminal::accepts_type(std::type_index ttype) const {
 }
 
 void gfInputTerminal::clear() {
+  std::lock_guard<std::recursive_mutex> lock(parent_.receive_mutex_);
   parent_.update_status();
-  parent_.on_clear(*this);
+  parent_.manager.call_on_main_thread(parent_, [this]() { parent_.on_clear(*this); });
 }
 
 gfSingleFeatureInputTerminal::~gfSingleFeatureInputTerminal(){
-  if (auto connected_output = connected_output_.lock())
-    connected_output->connections_.erase(get_ptr());
+  if (connected_output_ptr_) {
+    connected_output_ptr_->remove_connection(get_id());
+  }
 }
 bool gfSingleFeatureInputTerminal::is_connected_type(std::type_index ttype) const {
-  if(auto output_term = connected_output_.lock()) {
-    return output_term->accepts_type(ttype);
+  if (connected_output_ptr_) {
+    return connected_output_ptr_->accepts_type(ttype);
   }
   return false;
 }
 std::type_index gfSingleFeatureInputTerminal::get_connected_type() const {
-  if(auto output_term = connected_output_.lock()) {
-    return output_term->types_[0];
+  if (connected_output_ptr_) {
+    return connected_output_ptr_->types_[0];
   }
   return typeid(void);
 }
-void gfSingleFeatureInputTerminal::update_on_receive(bool queue) {
+void gfSingleFeatureInputTerminal::update_on_receive() {
   if(has_data() || is_touched()) {
-    if (queue && parent_.update_status() && parent_.autorun) 
-      parent_.queue();
-    parent_.on_receive(*this);
+    std::lock_guard<std::recursive_mutex> lock(parent_.receive_mutex_);
+    parent_.manager.call_on_main_thread(parent_, [this]() { parent_.on_receive(*this); });
   }
 }
 bool gfSingleFeatureInputTerminal::has_connection() {
-  return !connected_output_.expired();
+  return connected_output_ptr_ != nullptr;
 }
-bool gfSingleFeatureInputTerminal::has_data() const {
-  if (auto output_term = connected_output_.lock()) {
-    return output_term->has_data();
+bool gfInputTerminal::is_published() const {
+  auto outputs = get_connected_outputs();
+  if (outputs.empty()) return false;
+  for (auto& oT : outputs) {
+    if (!oT->is_published()) return false;
   }
+  return true;
+}
+bool gfSingleFeatureInputTerminal::has_data() const {
+  if (stream_batch_)
+    return stream_batch_->is_published();
+  if (connected_output_ptr_)
+    return connected_output_ptr_->is_published();
   return false;
 }
 bool gfSingleFeatureInputTerminal::is_touched() {
-  if (auto output_term = connected_output_.lock()) {
-    return output_term->is_touched();
-  }
+  if (stream_batch_)
+    return stream_batch_->is_touched();
+  if (connected_output_ptr_)
+    return connected_output_ptr_->is_touched();
   return false;
 }
 void gfSingleFeatureInputTerminal::connect_output(gfOutputTerminal& output_term) {
   //check if we are already connected and if so disconnect from that output term first 
-  if(auto output = connected_output_.lock()) {
-    output->disconnect(*this);
+  if (connected_output_ptr_) {
+    connected_output_ptr_->disconnect(*this);
   }
   connected_output_ = output_term.get_ptr();
+  connected_output_ptr_ = &output_term;
 }
 void gfSingleFeatureInputTerminal::disconnect_output(gfOutputTerminal& output_term) {
   connected_output_.reset();
+  connected_output_ptr_ = nullptr;
+}
+size_t gfSingleFeatureInputTerminal::get_input_version() const {
+  size_t version = 0;
+  if (connected_output_ptr_) {
+    hash_combine(version, connected_output_ptr_->get_id());
+    hash_combine(version, connected_output_ptr_->get_version());
+  }
+  return version;
+}
+std::vector<std::shared_ptr<gfOutputTerminal>> gfSingleFeatureInputTerminal::get_connected_outputs() const {
+  if (auto output_term = connected_output_.lock())
+    return {output_term};
+  return {};
+}
+void gfSingleFeatureInputTerminal::count_copied_bytes(size_t n_bytes) {
+  parent_.copied_bytes_ += n_bytes;
+}
+std::shared_ptr<gfSingleFeatureOutputTerminal> gfSingleFeatureInputTerminal::get_data_source() const {
+  if (stream_batch_)
+    return stream_batch_;
+  return std::static_pointer_cast<gfSingleFeatureOutputTerminal>(connected_output_.lock());
 }
 const std::vector<std::any>& gfSingleFeatureInputTerminal::get_data_vec() const {
-  auto output_term = connected_output_.lock();
-  auto sot = (gfSingleFeatureOutputTerminal*)(output_term.get());
-  return sot->get_data_vec();
+  return get_data_source()->get_data_vec();
+}
+std::any gfSingleFeatureInputTerminal::get_any(size_t i) const {
+  return get_data_source()->get_any(i);
+}
+bool gfSingleFeatureInputTerminal::is_contiguous() const {
+  if (auto output_term = get_data_source()) {
+    return output_term->is_contiguous();
+  }
+  return false;
 }
 size_t gfSingleFeatureInputTerminal::size() const {
-  auto output_term = connected_output_.lock();
-  auto sot = (gfSingleFeatureOutputTerminal*)(output_term.get());
-  return sot->size(); 
+  return get_data_source()->size(); 
 }
 
 
 gfOutputTerminal::~gfOutputTerminal() {
   for(auto& conn : connections_) {
-    if (auto in = conn.lock()) {
-      in->clear();
-    }
+    // forget this terminal before clearing, so that the input no longer reports its data
+    conn.terminal->disconnect_output(*this);
+    conn.terminal->clear();
   }
 }
 bool gfOutputTerminal::is_compatible(gfInputTerminal& input_terminal) {
@@ -128,21 +266,69 @@ bool gfOutputTerminal::is_compatible(gfInputTerminal& input_terminal) {
   bool family_compatible = (get_family()==input_terminal.get_family()) || (input_terminal.get_family() == GF_MULTI_FEATURE);
   return family_compatible && type_compatible;
 }
-const InputConnectionSet& gfOutputTerminal::get_connections(){
-  return connections_;
+InputConnectionSet gfOutputTerminal::get_connections() const {
+  std::shared_lock<std::shared_mutex> lock(connections_mutex_);
+  InputConnectionSet connections;
+  for (auto& conn : connections_) {
+    connections.insert(conn.ptr);
+  }
+  return connections;
+}
+std::vector<std::shared_ptr<gfInputTerminal>> gfOutputTerminal::get_connected_inputs() const {
+  std::shared_lock<std::shared_mutex> lock(connections_mutex_);
+  std::vector<std::shared_ptr<gfInputTerminal>> inputs;
+  for (auto& conn : connections_) {
+    if (auto input_term = conn.ptr.lock())
+      inputs.push_back(input_term);
+  }
+  return inputs;
+}
+std::vector<gfInputTerminal*> gfOutputTerminal::get_connected_input_ptrs() const {
+  std::shared_lock<std::shared_mutex> lock(connections_mutex_);
+  std::vector<gfInputTerminal*> inputs;
+  inputs.reserve(connections_.size());
+  for (auto& conn : connections_) {
+    inputs.push_back(conn.terminal);
+  }
+  return inputs;
+}
+size_t gfOutputTerminal::connection_count() const {
+  std::shared_lock<std::shared_mutex> lock(connections_mutex_);
+  return connections_.size();
+}
+void gfOutputTerminal::remove_connection(gfObjectId input_id) {
+  std::unique_lock<std::shared_mutex> lock(connections_mutex_);
+  connections_.erase(std::remove_if(connections_.begin(), connections_.end(), 
+    [input_id](const gfConnection<gfInputTerminal>& conn) { return conn.id == input_id; }), connections_.end());
+}
+void gfOutputTerminal::release() {
+  if (get_family() == GF_MULTI_FEATURE) {
+    for (auto& [name, sub_term] : static_cast<gfMultiFeatureOutputTerminal*>(this)->sub_terminals()) {
+      gfOutputTerminal* term = sub_term.get();
+      term->clear();
+    }
+    has_data_.store(false, std::memory_order_release);
+    is_touched_.store(false, std::memory_order_release);
+    ++version_;
+  } else {
+    clear();
+  }
 }
 void gfOutputTerminal::propagate() {
-  for (auto& conn : get_connections()) {
-    if (has_data() || is_touched())
-      conn.lock()->update_on_receive(true); // conn is the inputTerminal on the other end of the connection
+  // make the data written by this thread visible to the threads of the receiving nodes
+  publish();
+  if (!(is_published() || is_touched())) return;
+  for (auto input_term : get_connected_input_ptrs()) {
+    input_term->update_on_receive();
   }
 }
+size_t gfOutputTerminal::get_version() const {
+  return version_;
+}
 std::set<NodeHandle> gfOutputTerminal::get_child_nodes() {
   std::set<NodeHandle> child_nodes;
-  for (auto& conn : connections_) {
-    if (auto input_term = conn.lock()) {
-      child_nodes.insert(input_term->get_parent().get_handle());
-    }
+  for (auto input_term : get_connected_input_ptrs()) {
+    child_nodes.insert(input_term->get_parent().get_handle());
   }
   return child_nodes;
 }
@@ -155,15 +341,23 @@ void gfOutputTerminal::connect(gfInputTerminal& in) {
     throw gfException("Failed to connect ouput " +get_name()+ " from "+parent_.get_name()+" to input " + in.get_name() + " from " +in.parent_.get_name()+ ". Loop detected!");
 
   in.connect_output(*this);
-  connections_.insert(in.get_ptr());
+  {
+    std::unique_lock<std::shared_mutex> lock(connections_mutex_);
+    bool is_connected = std::any_of(connections_.begin(), connections_.end(), 
+      [&in](const gfConnection<gfInputTerminal>& conn) { return conn.terminal == &in; });
+    if (!is_connected)
+      connections_.push_back({in.get_id(), &in, in.get_ptr()});
+  }
+  parent_.manager.invalidate_execution_plan();
   parent_.on_connect_output(*this);
   in.get_parent().on_connect_input(in);
   if (has_data() || is_touched()) {
-    in.update_on_receive(false);
+    in.update_on_receive();
   }
 };
 void gfOutputTerminal::disconnect(gfInputTerminal& in) {
-  connections_.erase(in.get_ptr());
+  remove_connection(in.get_id());
+  parent_.manager.invalidate_execution_plan();
   in.disconnect_output(*this);
   in.clear();
   in.parent_.notify_children();
@@ -176,28 +370,47 @@ void gfOutputTerminal::disconnect(gfInputTerminal& in) {
 //   return data_.has_value();
 // }
 void gfSingleFeatureOutputTerminal::clear() {
-  data_.clear();
-  is_touched_ = false;
-}
-bool gfSingleFeatureOutputTerminal::has_data() const {
-  return data_.size()!=0;
+  has_data_.store(false, std::memory_order_release);
+  is_touched_.store(false, std::memory_order_release);
+  clear_data();
+  ++version_;
+}
+bool gfSingleFeatureOutputTerminal::data_available() const {
+  return size()!=0;
+}
+std::shared_ptr<gfSingleFeatureOutputTerminal> gfSingleFeatureOutputTerminal::take_batch() {
+  auto batch = std::make_shared<gfSingleFeatureOutputTerminal>(parent_, get_name(), types_, supports_multiple_elements());
+  batch->data_.swap(data_);
+  batch->data_bytes_ = data_bytes_;
+  if (column_) {
+    batch->column_ = std::move(column_);
+    column_ = batch->column_->create_empty();
+  }
+  batch->touch();
+  has_data_.store(false, std::memory_order_release);
+  ++version_;
+  return batch;
 }
 
 gfMultiFeatureInputTerminal::~gfMultiFeatureInputTerminal(){
-  for (auto output_term_ : connected_outputs_) {
-    if(auto output_term = output_term_.lock())
-      output_term->connections_.erase(get_ptr());
+  for (auto& conn : connected_outputs_) {
+    conn.terminal->remove_connection(get_id());
   }
 }
 void gfMultiFeatureInputTerminal::clear() {
+  std::lock_guard<std::recursive_mutex> lock(parent_.receive_mutex_);
   rebuild_terminal_refs();
   gfInputTerminal::clear();
 }
 void gfMultiFeatureInputTerminal::connect_output(gfOutputTerminal& output_term) {
-  connected_outputs_.insert(output_term.get_ptr());
+  for (auto& conn : connected_outputs_) {
+    if (conn.terminal == &output_term) return;
+  }
+  connected_outputs_.push_back({output_term.get_id(), &output_term, output_term.get_ptr()});
 }
 void gfMultiFeatureInputTerminal::disconnect_output(gfOutputTerminal& output_term) {
-  connected_outputs_.erase(output_term.get_ptr());
+  connected_outputs_.erase(std::remove_if(connected_outputs_.begin(), connected_outputs_.end(), 
+    [&output_term](const gfConnection<gfOutputTerminal>& conn) { return conn.terminal == &output_term; }), connected_outputs_.end());
 }
 void gfMultiFeatureInputTerminal::push_term_ref(gfOutputTerminal* term_ptr) {
   auto oterm_ptr = static_cast<gfSingleFeatureOutputTerminal*>(term_ptr);
@@ -212,73 +425,98 @@ void gfMultiFeatureInputTerminal::push_term_ref(gfOutputTerminal* term_ptr) {
 void gfMultiFeatureInputTerminal::rebuild_terminal_refs() {
   sub_terminals_.clear();
   // vector_terminals_.clear();
-  for (auto& wptr : connected_outputs_) {
-    if (auto term = wptr.lock()) {
-      auto term_ptr = term.get();
-      if (auto poly_term_ptr = dynamic_cast<gfMultiFeatureOutputTerminal*>(term_ptr)) {
-        for (auto& [name, sub_term] : poly_term_ptr->sub_terminals()) {
-          push_term_ref(sub_term.get());
-        }
-      } else {
-        push_term_ref(term_ptr);
+  for (auto& conn : connected_outputs_) {
+    auto term_ptr = conn.terminal;
+    if (auto poly_term_ptr = dynamic_cast<gfMultiFeatureOutputTerminal*>(term_ptr)) {
+      for (auto& [name, sub_term] : poly_term_ptr->sub_terminals()) {
+        push_term_ref(sub_term.get());
       }
+    } else {
+      push_term_ref(term_ptr);
     }
   }
 }
-void gfMultiFeatureInputTerminal::update_on_receive(bool queue) {
+void gfMultiFeatureInputTerminal::update_on_receive() {
+  std::lock_guard<std::recursive_mutex> lock(parent_.receive_mutex_);
   rebuild_terminal_refs();
-  if (parent_.update_status()) {
-    if (queue && parent_.autorun)
-      parent_.queue();
-  }
-  parent_.on_receive(*this);
+  parent_.update_status();
+  parent_.manager.call_on_main_thread(parent_, [this]() { parent_.on_receive(*this); });
 }
 bool gfMultiFeatureInputTerminal::has_data() const {
   if (connected_outputs_.size()==0)
     return false;
-  for (auto output_term_ : connected_outputs_){
-    if (auto output_term = output_term_.lock()) {
-      if (!output_term->has_data()) {
-        return false;
-      }
+  for (auto& conn : connected_outputs_){
+    if (!conn.terminal->is_published()) {
+      return false;
     }
   }
   return true;
 }
 bool gfMultiFeatureInputTerminal::is_touched() {
-  for (auto output_term_ : connected_outputs_){
-    if (auto output_term = output_term_.lock()) {
-      if (!output_term->is_touched()) {
-        return true;
-      }
+  for (auto& conn : connected_outputs_){
+    if (!conn.terminal->is_touched()) {
+      return true;
     }
   }
   return false;
 }
+size_t gfMultiFeatureInputTerminal::get_input_version() const {
+  size_t version = 0;
+  for (auto& conn : connected_outputs_) {
+    hash_combine(version, conn.id);
+    hash_combine(version, conn.terminal->get_version());
+  }
+  return version;
+}
+std::vector<std::shared_ptr<gfOutputTerminal>> gfMultiFeatureInputTerminal::get_connected_outputs() const {
+  std::vector<std::shared_ptr<gfOutputTerminal>> outputs;
+  for (auto& conn : connected_outputs_) {
+    if (auto output_term = conn.ptr.lock())
+      outputs.push_back(output_term);
+  }
+  return outputs;
+}
 size_t gfMultiFeatureInputTerminal::size() const{
   if (connected_outputs_.size()==0)
     return 0;
   else
-    return connected_outputs_.begin()->lock()->size();
+    return connected_outputs_.front().terminal->size();
 }
 
 void gfMultiFeatureOutputTerminal::clear() {
   // for (auto& [name, t] : terminals_) {
   //   t->clear();
   // }
+  has_data_.store(false, std::memory_order_release);
+  is_touched_.store(false, std::memory_order_release);
   terminals_.clear();
-  is_touched_ = false;
+  ++version_;
 }
-bool gfMultiFeatureOutputTerminal::has_data() const {
+size_t gfMultiFeatureOutputTerminal::get_version() const {
+  size_t version = version_;
+  for (auto& [name, term] : terminals_) {
+    hash_combine(version, std::hash<const void*>()(term.get()));
+    hash_combine(version, term->get_version());
+  }
+  return version;
+}
+bool gfMultiFeatureOutputTerminal::data_available() const {
   if(terminals_.size()==0) {
     return false;
   }
   for (auto& [name, t] : terminals_) {
-    if(!t->has_data())
+    if(!t->data_available())
       return false;
   }
   return true;
 }
+void gfMultiFeatureOutputTerminal::propagate() {
+  // sub terminals that were filled without touch(), eg. with push_back_any(), are not published yet
+  for (auto& [name, t] : terminals_) {
+    t->publish();
+  }
+  gfOutputTerminal::propagate();
+}
 size_t gfMultiFeatureOutputTerminal::size() const {
   if (terminals_.size()==0)
     return 0;
@@ -322,10 +560,8 @@ void Node::set_name(std::string new_name) {
 std::set<NodeHandle> Node::get_child_nodes() {
   std::set<NodeHandle> child_nodes;
   for (auto& [name, oT] : output_terminals) {
-    for (auto& conn : oT->get_connections()) {
-      if (auto input_term = conn.lock()) {
-        child_nodes.insert(input_term->get_parent().get_handle());
-      }
+    for (auto input_term : oT->get_connected_input_ptrs()) {
+      child_nodes.insert(input_term->get_parent().get_handle());
     }
   }
   return child_nodes;
@@ -346,20 +582,26 @@ bool Node::inputs_valid() {
   return true;
 }
 bool Node::update_status() {
-  auto status_before = status_;
-  if (inputs_valid())
-    status_ = GF_NODE_READY;
-  else
-    status_ = GF_NODE_WAITING;
-  return status_ != status_before;
-}
-bool Node::queue() {
-  if(status_==GF_NODE_READY) {
-    manager.queue(get_handle());
-    return true;
+  auto new_status = inputs_valid() ? GF_NODE_READY : GF_NODE_WAITING;
+  auto status_before = status_.exchange(new_status);
+  return new_status != status_before;
+}
+void Node::emit_batch() {
+  if (stream_channels_.empty()) return;
+  bool has_elements = false;
+  for (auto oT : stream_outputs_) {
+    has_elements |= oT->size() > 0;
   }
-  return false;
-};
+  if (!has_elements) return;
+  auto batch = std::make_shared<StreamBatch>();
+  for (auto oT : stream_outputs_) {
+    (*batch)[oT] = oT->take_batch();
+  }
+  for (auto& channel : stream_channels_) {
+    if (!channel->push(batch))
+      throw gfException("A streaming consumer of " + get_name() + " failed");
+  }
+}
 void Node::propagate_outputs() {
   for_each_output([](gfOutputTerminal& oT) {
     oT.propagate();
@@ -370,34 +612,180 @@ void Node::propagate_outputs() {
 }
 void Node::notify_children() {
   std::queue<Node*> nodes_to_check;
-  std::set<Node*> visited;
+  std::unordered_set<gfObjectId> visited;
   nodes_to_check.push(this);
 
   while (!nodes_to_check.empty()) {
     auto n = nodes_to_check.front();
     nodes_to_check.pop();
+    n->run_signature_ = 0;
     
     n->for_each_output([&nodes_to_check, &visited](gfOutputTerminal& oT) {
       oT.clear();
-      for (auto& conn : oT.get_connections()) {
-        if (auto iT = conn.lock()) {
-          iT->clear();
-          auto child_node = iT->get_parent().get_handle().get();
-          if (visited.count(child_node)==0) {
-            visited.insert(child_node);
-            nodes_to_check.push(child_node);
-          }
+      for (auto iT : oT.get_connected_input_ptrs()) {
+        iT->clear();
+        auto child_node = &iT->get_parent();
+        if (visited.insert(child_node->get_id()).second) {
+          nodes_to_check.push(child_node);
         }
       }
     });
 
   }
 }
+size_t Node::compute_signature() const {
+  size_t signature = std::hash<std::string>()(node_register->get_name() + "." + type_name);
+  for (auto& [name, param] : parameters) {
+    json value;
+    if (auto master = param->get_master().lock())
+      value = master->as_json();
+    else
+      value = param->as_json();
+    // strings may refer to globals, eg. a filepath with {{GF_I}}
+    if (value.is_string())
+      value = manager.substitute_globals(value.get<std::string>());
+    hash_combine(signature, std::hash<std::string>()(name + "=" + value.dump()));
+  }
+  for (auto& [name, iT] : input_terminals) {
+    hash_combine(signature, std::hash<std::string>()(name));
+    hash_combine(signature, iT->get_input_version());
+  }
+  // 0 is reserved for 'unknown'
+  return signature == 0 ? 1 : signature;
+}
+bool Node::outputs_valid() {
+  for (auto& [name, oT] : output_terminals) {
+    if (!(oT->is_published() || oT->is_touched()))
+      return false;
+  }
+  return true;
+}
+void Node::clear_outputs() {
+  for_each_output([](gfOutputTerminal& oT) {
+    oT.clear();
+    for (auto iT : oT.get_connected_input_ptrs()) {
+      iT->clear();
+    }
+  });
+}
+uint64_t Node::compute_cache_key() const {
+  std::stringstream key;
+  key << "v" << cache_format_version << "\n";
+  key << node_register->get_name() << "." << type_name << "\n";
+  json params_j;
+  for (auto& [name, param] : parameters) {
+    json value = param->as_json();
+    if (value.is_string())
+      value = manager.substitute_globals(value.get<std::string>());
+    params_j[name] = value;
+  }
+  key << params_j.dump() << "\n";
+  for (auto& [name, iT] : input_terminals) {
+    // sort the connections, a multi feature input keeps them in a pointer ordered set
+    std::vector<std::string> upstream;
+    for (auto& oT : iT->get_connected_outputs()) {
+      auto upstream_key = oT->get_parent().cache_key_;
+      if (upstream_key == 0) return 0;
+      upstream.push_back(std::to_string(upstream_key) + "." + oT->get_name());
+    }
+    std::sort(upstream.begin(), upstream.end());
+    key << name << ":";
+    for (auto& u : upstream) key << u << ",";
+    key << "\n";
+  }
+  auto hash = fnv1a_hash(key.str());
+  return hash == 0 ? 1 : hash;
+}
+void Node::write_outputs(std::ostream& os) {
+  auto& serialisers = SerialiserRegistry::get();
+  auto write_terminal = [&](gfSingleFeatureOutputTerminal& term) {
+    write_binary(os, term.is_touched());
+    write_binary(os, uint64_t(term.size()));
+    for (size_t i=0; i<term.size(); ++i) {
+      serialisers.write(os, term.get_any(i));
+    }
+  };
+  write_binary(os, uint64_t(output_terminals.size()));
+  for (auto& [name, oT] : output_terminals) {
+    write_binary(os, name);
+    if (oT->get_family() == GF_SINGLE_FEATURE) {
+      write_terminal(*static_cast<gfSingleFeatureOutputTerminal*>(oT.get()));
+    } else {
+      auto& poly_term = *static_cast<gfMultiFeatureOutputTerminal*>(oT.get());
+      write_binary(os, poly_term.is_touched());
+      write_binary(os, uint64_t(poly_term.sub_terminals().size()));
+      for (auto& [sub_name, sub_term] : poly_term.sub_terminals()) {
+        write_binary(os, sub_name);
+        write_binary(os, serialisers.get_name(sub_term->get_type()));
+        write_binary(os, sub_term->supports_multiple_elements());
+        write_terminal(*sub_term);
+      }
+    }
+  }
+}
+void Node::read_outputs(std::istream& is) {
+  auto& serialisers = SerialiserRegistry::get();
+  auto check_stream = [&is]() {
+    if (!is) throw gfException("unexpected end of cache file");
+  };
+  auto read_terminal = [&](gfSingleFeatureOutputTerminal& term) {
+    bool is_touched; 
+    uint64_t n;
+    read_binary(is, is_touched);
+    read_binary(is, n);
+    check_stream();
+    for (uint64_t i=0; i<n; ++i) {
+      term.push_back_any(serialisers.read(is));
+      check_stream();
+    }
+    if (is_touched) term.touch();
+  };
+  try {
+    uint64_t n_terms;
+    read_binary(is, n_terms);
+    check_stream();
+    if (n_terms != output_terminals.size())
+      throw gfException("cached outputs do not match the output terminals of " + get_name());
+    for (uint64_t t=0; t<n_terms; ++t) {
+      std::string name;
+      read_binary(is, name);
+      check_stream();
+      auto& oT = output_terminals.at(name);
+      oT->clear();
+      if (oT->get_family() == GF_SINGLE_FEATURE) {
+        read_terminal(*static_cast<gfSingleFeatureOutputTerminal*>(oT.get()));
+      } else {
+        auto& poly_term = *static_cast<gfMultiFeatureOutputTerminal*>(oT.get());
+        bool is_touched;
+        uint64_t n_sub;
+        read_binary(is, is_touched);
+        read_binary(is, n_sub);
+        check_stream();
+        for (uint64_t i=0; i<n_sub; ++i) {
+          std::string sub_name, type_name;
+          bool is_vector;
+          read_binary(is, sub_name);
+          read_binary(is, type_name);
+          read_binary(is, is_vector);
+          check_stream();
+          auto type = serialisers.get_type(type_name);
+          auto& sub_term = is_vector ? poly_term.add_vector(sub_name, type) : poly_term.add(sub_name, type);
+          read_terminal(sub_term);
+        }
+        if (is_touched) poly_term.touch();
+      }
+    }
+  } catch (...) {
+    // do not leave partially restored outputs behind
+    for_each_output([](gfOutputTerminal& oT) { oT.clear(); });
+    throw;
+  }
+}
 std::string Node::debug_info() {
   std::stringstream s;
   s << "addr: " << this << "\n";
   s << "status: ";
-  switch (status_) {
+  switch (status_.load()) {
     case GF_NODE_WAITING: s << "WAITING"; break;
     case GF_NODE_READY: s << "READY"; break;
     case GF_NODE_PROCESSING: s << "PROCESSING"; break;
@@ -407,15 +795,280 @@ std::string Node::debug_info() {
   s << "\n";
   s << "Outputerminals:\n";
   for (auto& [name, oT] : output_terminals) {
-    s << "- [" << oT->has_data() <<"/"<< oT->get_connections().size() << "] " << name << ", " << &(*oT) << "\n";
+    s << "- [" << oT->has_data() <<"/"<< oT->connection_count() << "] " << name << ", " << &(*oT) << "\n";
   }
   return s.str();
 }
 
-void NodeManager::queue(std::shared_ptr<Node> n) {
-  node_queue.push(n);
+void NodeManager::process_node(Node& n) {
+  n.status_ = GF_NODE_PROCESSING;
+  n.copied_bytes_ = 0;
+  auto rss_start = peak_rss_kb();
+  auto cpu_start = thread_cpu_time_ms();
+  auto wall_start = std::chrono::steady_clock::now();
+
+  // copy parameter values from master if a master is set
+  for (auto& [name, param] : n.parameters) {
+    param->copy_value_from_master();
+  }
+  n.cache_key_ = cache_dir.empty() ? 0 : n.compute_cache_key();
+  // the outputs of streaming nodes only hold the last batch, so they can not be cached
+  bool use_cache = n.use_disk_cache && n.cache_key_ && !n.stream_producer_ && n.stream_consumers_.empty();
+  if (!(use_cache && load_cached_outputs(n))) {
+    n.process();
+    if (use_cache)
+      store_cached_outputs(n);
+  }
+
+  auto wall_end = std::chrono::steady_clock::now();
+  auto& metrics = n.metrics_;
+  ++metrics.calls;
+  metrics.wall_time_ms = std::chrono::duration<double, std::milli>(wall_end-wall_start).count();
+  metrics.cpu_time_ms = thread_cpu_time_ms() - cpu_start;
+  metrics.total_wall_time_ms += metrics.wall_time_ms;
+  metrics.total_cpu_time_ms += metrics.cpu_time_ms;
+  metrics.peak_rss_delta_kb = peak_rss_kb() - rss_start;
+  metrics.output_bytes.clear();
+  size_t output_bytes = 0;
+  for (auto& [name, oT] : n.output_terminals) {
+    output_bytes += metrics.output_bytes[name] = output_data_bytes(*oT);
+  }
+  // learn the memory use of this node for the next runs
+  size_t measured_kb = std::max(size_t(std::max(metrics.peak_rss_delta_kb, 0L)), output_bytes / 1024);
+  n.memory_estimate_kb = std::max(n.memory_estimate_kb, measured_kb);
+  size_t live_bytes = live_output_bytes_ += output_bytes;
+  size_t peak_bytes = peak_output_bytes_;
+  while (live_bytes > peak_bytes && !peak_output_bytes_.compare_exchange_weak(peak_bytes, live_bytes));
+  if (record_trace) {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    auto thread = trace_threads_.emplace(std::this_thread::get_id(), trace_threads_.size()).first->second;
+    trace_events_.push_back({
+      n.get_name(), 
+      n.get_register().get_name() + "." + n.get_type_name(), 
+      thread,
+      std::chrono::duration<double, std::micro>(wall_start-trace_start_).count(),
+      std::chrono::duration<double, std::micro>(wall_end-wall_start).count(),
+      metrics
+    });
+  }
+  n.status_ = GF_NODE_DONE;
+}
+void NodeManager::dump_trace(std::string filepath) {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  json j;
+  j["displayTimeUnit"] = "ms";
+  j["traceEvents"] = json::array();
+  for (auto& [id, thread] : trace_threads_) {
+    j["traceEvents"].push_back({
+      {"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", thread}, 
+      {"args", {{"name", "worker " + std::to_string(thread)}}}
+    });
+  }
+  for (auto& event : trace_events_) {
+    j["traceEvents"].push_back({
+      {"name", event.name}, {"cat", event.category}, {"ph", "X"}, {"pid", 0}, {"tid", event.thread},
+      {"ts", event.start_us}, {"dur", event.duration_us},
+      {"args", {
+        {"cpu_time_ms", event.metrics.cpu_time_ms},
+        {"peak_rss_delta_kb", event.metrics.peak_rss_delta_kb},
+        {"output_bytes", event.metrics.output_bytes}
+      }}
+    });
+  }
+  std::ofstream ofs(filepath);
+  ofs << j.dump() << std::endl;
+}
+void NodeManager::clear_trace() {
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  trace_events_.clear();
+  trace_threads_.clear();
+  trace_start_ = std::chrono::steady_clock::now();
+}
+void NodeManager::print_metrics(std::ostream& os) {
+  std::vector<NodeHandle> sorted_nodes;
+  for (auto& [name, node] : nodes) {
+    if (node->get_metrics().calls) sorted_nodes.push_back(node);
+  }
+  std::sort(sorted_nodes.begin(), sorted_nodes.end(), [](const NodeHandle& a, const NodeHandle& b) {
+    return a->get_metrics().total_wall_time_ms > b->get_metrics().total_wall_time_ms;
+  });
+  auto flags = os.flags();
+  auto precision = os.precision();
+  os << std::left << std::setw(32) << "node" << std::right
+     << std::setw(8) << "calls" 
+     << std::setw(14) << "wall [ms]" 
+     << std::setw(14) << "cpu [ms]" 
+     << std::setw(16) << "peak rss [kB]" 
+     << std::setw(16) << "output [kB]" << "\n";
+  for (auto& node : sorted_nodes) {
+    auto& m = node->get_metrics();
+    size_t output_bytes = 0;
+    for (auto& [name, n_bytes] : m.output_bytes) output_bytes += n_bytes;
+    os << std::left << std::setw(32) << node->get_name() << std::right
+       << std::setw(8) << m.calls
+       << std::fixed << std::setprecision(1)
+       << std::setw(14) << m.total_wall_time_ms
+       << std::setw(14) << m.total_cpu_time_ms
+       << std::setw(16) << m.peak_rss_delta_kb
+       << std::setw(16) << output_bytes / 1024.0 << "\n";
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+MemoryReport NodeManager::get_memory_report() const {
+  MemoryReport report;
+  report.peak_output_bytes = peak_output_bytes_;
+  report.released_output_bytes = released_output_bytes_;
+  report.released_terminals = released_terminals_;
+  report.peak_rss_kb = peak_rss_kb();
+  report.deferred = deferred_;
+  return report;
+}
+void NodeManager::print_memory_report(std::ostream& os) {
+  auto report = get_memory_report();
+  auto flags = os.flags();
+  auto precision = os.precision();
+  os << std::fixed << std::setprecision(1)
+     << std::left << std::setw(32) << "peak output data [kB]" << std::right << std::setw(16) << report.peak_output_bytes / 1024.0 << "\n"
+     << std::left << std::setw(32) << "released outputs" << std::right << std::setw(16) << report.released_terminals << "\n"
+     << std::left << std::setw(32) << "released output data [kB]" << std::right << std::setw(16) << report.released_output_bytes / 1024.0 << "\n"
+     << std::left << std::setw(32) << "peak rss [kB]" << std::right << std::setw(16) << report.peak_rss_kb << "\n";
+  if (memory_budget_kb)
+    os << std::left << std::setw(32) << "deferred by memory budget" << std::right << std::setw(16) << report.deferred << "\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+void NodeManager::begin_output_release(const std::vector<Node*>& run_nodes) {
+  end_output_release();
+  live_output_bytes_ = 0;
+  peak_output_bytes_ = 0;
+  released_output_bytes_ = 0;
+  released_terminals_ = 0;
+  deferred_ = 0;
+  // incremental runs need the outputs of unchanged nodes
+  if (!release_consumed_outputs || incremental) return;
+
+  std::unordered_set<const Node*> in_run(run_nodes.begin(), run_nodes.end());
+  for (auto n : run_nodes) {
+    // streaming consumers read batches instead of the outputs of their producer
+    if (!n->stream_consumers_.empty()) continue;
+    for (auto& [name, oT] : n->output_terminals) {
+      if (oT->is_marked() || oT->get_keep_data()) continue;
+      auto inputs = oT->get_connected_input_ptrs();
+      bool releasable = !inputs.empty();
+      for (auto iT : inputs) {
+        auto& consumer = iT->get_parent();
+        releasable &= in_run.count(&consumer) && !iT->is_marked() && !consumer.requires_main_thread();
+      }
+      if (!releasable) continue;
+      oT->pending_consumers_ = inputs.size();
+      release_terminals_.push_back(oT.get());
+    }
+  }
+}
+void NodeManager::release_consumed_inputs(Node& n) {
+  if (release_terminals_.empty()) return;
+  for (auto& [name, iT] : n.input_terminals) {
+    for (auto& oT : iT->get_connected_outputs()) {
+      // not counted, or other consumers still need the data
+      if (oT->pending_consumers_ == 0 || --oT->pending_consumers_ != 0) continue;
+      // subtract what was added to live_output_bytes_ when the data was produced
+      auto& produced = oT->get_parent().get_metrics().output_bytes;
+      auto it = produced.find(oT->get_name());
+      size_t n_bytes = it == produced.end() ? 0 : it->second;
+      oT->release();
+      live_output_bytes_ -= std::min<size_t>(n_bytes, live_output_bytes_);
+      released_output_bytes_ += n_bytes;
+      ++released_terminals_;
+    }
+  }
+}
+size_t NodeManager::reserve_memory(size_t estimate_kb) {
+  if (memory_budget_source_) return memory_budget_source_->reserve_memory(estimate_kb);
+  if (memory_budget_kb == 0 || estimate_kb == 0) return 0;
+  // an estimate larger than the budget can only run alone
+  estimate_kb = std::min(estimate_kb, memory_budget_kb);
+  std::unique_lock<std::mutex> lock(memory_mutex_);
+  if (reserved_memory_kb_ + estimate_kb > memory_budget_kb) {
+    ++deferred_;
+    memory_released_.wait(lock, [this, estimate_kb]() { return reserved_memory_kb_ + estimate_kb <= memory_budget_kb; });
+  }
+  reserved_memory_kb_ += estimate_kb;
+  return estimate_kb;
+}
+void NodeManager::release_memory(size_t reserved_kb) {
+  if (memory_budget_source_) return memory_budget_source_->release_memory(reserved_kb);
+  if (reserved_kb == 0) return;
+  {
+    std::lock_guard<std::mutex> lock(memory_mutex_);
+    reserved_memory_kb_ -= reserved_kb;
+  }
+  memory_released_.notify_all();
+}
+void NodeManager::share_memory_budget(NodeManager& other_manager) {
+  memory_budget_kb = other_manager.memory_budget_kb;
+  memory_budget_source_ = &other_manager;
+}
+void NodeManager::end_output_release() {
+  for (auto oT : release_terminals_) {
+    oT->pending_consumers_ = 0;
+  }
+  release_terminals_.clear();
+}
+static std::string cache_filepath(const std::string& cache_dir, uint64_t key) {
+  std::stringstream filename;
+  filename << std::hex << std::setw(16) << std::setfill('0') << key << ".gfc";
+  return (fs::path(cache_dir) / filename.str()).string();
+}
+bool NodeManager::load_cached_outputs(Node& n) {
+  std::ifstream ifs(cache_filepath(cache_dir, n.cache_key_), std::ios::binary);
+  if (!ifs.is_open())
+    return false;
+  try {
+    n.read_outputs(ifs);
+  } catch (const std::exception& e) {
+    std::cout << "Failed to read cached outputs of " << n.get_name() << ": " << e.what() << "\n";
+    return false;
+  }
+  return true;
+}
+void NodeManager::store_cached_outputs(Node& n) {
+  auto filepath = cache_filepath(cache_dir, n.cache_key_);
+  // write to a temporary file first, so that other processes never see a partially written cache file
+  std::stringstream tmp_filepath_;
+  tmp_filepath_ << filepath << "." << std::this_thread::get_id() << "." << std::chrono::steady_clock::now().time_since_epoch().count();
+  auto tmp_filepath = tmp_filepath_.str();
+  try {
+    fs::create_directories(cache_dir);
+    {
+      std::ofstream ofs(tmp_filepath, std::ios::binary);
+      if (!ofs.is_open())
+        throw gfException("unable to open " + tmp_filepath);
+      n.write_outputs(ofs);
+      if (!ofs)
+        throw gfException("unable to write " + tmp_filepath);
+    }
+    fs::rename(tmp_filepath, filepath);
+  } catch (const std::exception& e) {
+    std::cout << "Failed to cache outputs of " << n.get_name() << ": " << e.what() << "\n";
+    std::error_code ec;
+    fs::remove(tmp_filepath, ec);
+  }
+}
+size_t NodeManager::get_worker_count() const {
+  if (n_threads == 0)
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  return n_threads;
+}
+tf::Executor& NodeManager::get_executor() {
+  if (!executor_ || executor_->num_workers() != get_worker_count())
+    executor_ = std::make_shared<tf::Executor>(get_worker_count());
+  return *executor_;
 }
 size_t NodeManager::run_all(bool notify_children) {
+  if (incremental || streaming || get_worker_count() > 1)
+    return run_all_parallel(notify_children);
+
   // find all root nodes with autorun enabled
   std::vector<NodeHandle> to_run;
   for (auto& [name, node] : nodes) {
@@ -428,44 +1081,565 @@ size_t NodeManager::run_all(bool notify_children) {
       node->notify_children();
     }
   }
+  begin_output_release(get_execution_plan()->nodes);
   size_t run_count = 0;
-  for (auto& node : to_run){
-    run_count += run(node, notify_children);
+  try {
+    for (auto& node : to_run){
+      run_count += run(node, notify_children);
+    }
+  } catch (...) {
+    end_output_release();
+    throw;
   }
+  end_output_release();
   return run_count;
 }
+// position of n in the plan. Nodes that are part of a cycle or of another flowchart are not in the plan
+static size_t plan_index(const ExecutionPlan& plan, const Node& n) {
+  auto it = plan.index.find(&n);
+  if (it == plan.index.end())
+    throw gfException("Node " + n.get_name() + " can not be run, it is part of a cycle or of another flowchart");
+  return it->second;
+}
+std::shared_ptr<const ExecutionPlan> NodeManager::get_execution_plan() {
+  std::lock_guard<std::mutex> lock(plan_mutex_);
+  size_t version = graph_version_;
+  if (plan_ && plan_version_ == version)
+    return plan_;
+
+  auto plan = std::make_shared<ExecutionPlan>();
+  // sort by name, so that the order of independent nodes does not depend on the hash map
+  std::vector<Node*> sorted_nodes;
+  for (auto& [name, node] : nodes) 
+    sorted_nodes.push_back(node.get());
+  std::sort(sorted_nodes.begin(), sorted_nodes.end(), [](Node* a, Node* b) { return a->get_name() < b->get_name(); });
+
+  std::unordered_map<Node*, std::vector<Node*>> node_children;
+  std::unordered_map<Node*, size_t> parent_count;
+  for (auto n : sorted_nodes) {
+    // a child may be connected to several outputs of n
+    std::set<Node*> unique_children;
+    for (auto& [name, oT] : n->output_terminals) {
+      for (auto iT : oT->get_connected_input_ptrs())
+        unique_children.insert(&iT->get_parent());
+    }
+    auto& children = node_children[n];
+    for (auto child : unique_children) {
+      children.push_back(child);
+      ++parent_count[child];
+    }
+  }
+  // Kahn's algorithm
+  std::queue<Node*> ready;
+  for (auto n : sorted_nodes) {
+    if (parent_count[n] == 0) ready.push(n);
+  }
+  auto remaining = parent_count;
+  while (!ready.empty()) {
+    auto n = ready.front();
+    ready.pop();
+    plan->index[n] = plan->nodes.size();
+    plan->nodes.push_back(n);
+    for (auto child : node_children[n]) {
+      if (--remaining[child] == 0) ready.push(child);
+    }
+  }
+  plan->child_offsets.push_back(0);
+  for (auto n : plan->nodes) {
+    for (auto child : node_children[n]) {
+      // children that are not in nodes (eg. of another flowchart) are left out
+      auto it = plan->index.find(child);
+      if (it != plan->index.end()) plan->children.push_back(it->second);
+    }
+    plan->child_offsets.push_back(plan->children.size());
+    plan->parent_count.push_back(parent_count[n]);
+  }
+  plan_ = plan;
+  plan_version_ = version;
+  return plan_;
+}
 size_t NodeManager::run(Node &node, bool notify_children) {
-  std::queue<std::shared_ptr<Node>>().swap(node_queue); // clear to prevent double processing of nodes ()
   node.update_status();
+  if (node.status_ != GF_NODE_READY) return 0;
+  if (notify_children) node.notify_children();
+
+  auto plan = get_execution_plan();
+  auto start = plan_index(*plan, node);
+  size_t n_nodes = plan->nodes.size();
+  auto children = [&plan](size_t i) {
+    return std::make_pair(plan->children.begin() + plan->child_offsets[i], plan->children.begin() + plan->child_offsets[i+1]);
+  };
+  // count for each node downstream of node its parents that are also downstream of node. Parents come before their 
+  // children in the plan, so one pass suffices
+  std::vector<size_t> remaining(n_nodes, 0);
+  std::vector<char> reachable(n_nodes, 0), triggered(n_nodes, 0);
+  reachable[start] = triggered[start] = 1;
+  size_t n_reachable = 0;
+  for (size_t i=start; i<n_nodes; ++i) {
+    if (!reachable[i]) continue;
+    ++n_reachable;
+    auto [begin, end] = children(i);
+    for (auto c = begin; c != end; ++c) {
+      reachable[*c] = 1;
+      ++remaining[*c];
+    }
+  }
+  progress_total_ += n_reachable;
+
+  // a node is considered once all its parents were considered, and it is processed if one of its parents was processed 
+  // and all its inputs have data
   size_t run_count = 0;
-  if (node.queue()) {
-    if (notify_children) node.notify_children();
-    while (!node_queue.empty()) {
-      auto n = node_queue.front();
-      node_queue.pop();
-      n->status_ = GF_NODE_PROCESSING;
-      // n->preprocess();
+  std::queue<size_t> ready;
+  ready.push(start);
+  while (!ready.empty()) {
+    auto i = ready.front();
+    ready.pop();
+    auto n = plan->nodes[i];
+    bool process = i == start;
+    if (!process && triggered[i] && n->autorun) {
+      n->update_status();
+      process = n->status_ == GF_NODE_READY;
+    }
+    if (process) {
       std::cout << "P " << n->get_name() << "..." << std::flush;
-      std::clock_t c_start = std::clock(); // CPU time
-      // copy parameter values from master if a master is set
-      for (auto& [name, param] : n->parameters) {
-        param->copy_value_from_master();
-      }
-//      try {
-        n->process();
-        n->status_ = GF_NODE_DONE;
+      process_node(*n);
+      ++run_count;
+      n->propagate_outputs();
+      release_consumed_inputs(*n);
+      std::cout << n->get_metrics().wall_time_ms << "ms" << copied_bytes_note(*n) << "\n";
+    }
+    ++progress_done_;
+    auto [begin, end] = children(i);
+    for (auto c = begin; c != end; ++c) {
+      if (process) triggered[*c] = 1;
+      if (--remaining[*c] == 0) ready.push(*c);
+    }
+  }
+  return run_count;
+}
+bool NodeManager::run_single(Node& node) {
+  node.update_status();
+  if (node.status_ != GF_NODE_READY || !node.autorun)
+    return false;
+  process_node(node);
+  node.propagate_outputs();
+  return true;
+}
+size_t NodeManager::run_all_parallel(bool notify_children) {
+  std::vector<NodeHandle> roots;
+  for (auto& [name, node] : nodes) {
+    if(node->is_root() && node->autorun) {
+      roots.push_back(node);
+    }
+  }
+  // in incremental mode the outputs of unchanged nodes must be kept
+  if(notify_children && !incremental) {
+    for (auto& node : roots){
+      node->notify_children();
+    }
+  }
+
+  // collect all nodes that are downstream of a root node, in topological order
+  auto plan = get_execution_plan();
+  std::vector<Node*> run_nodes;
+  std::vector<char> reachable(plan->nodes.size(), 0);
+  for (auto& node : roots) {
+    reachable[plan_index(*plan, *node)] = 1;
+  }
+  for (size_t i=0; i<plan->nodes.size(); ++i) {
+    if (!reachable[i]) continue;
+    run_nodes.push_back(plan->nodes[i]);
+    for (auto c=plan->child_offsets[i]; c<plan->child_offsets[i+1]; ++c) {
+      reachable[plan->children[c]] = 1;
+    }
+  }
+  if (streaming)
+    plan_streaming(run_nodes);
+  begin_output_release(run_nodes);
+
+  // build a task graph with one task per node. A node is only processed after all of its parents in this graph are finished.
+  // Streaming consumers do not get a task, they are run by the task of the first producer in their stream
+  auto task_node = [](Node* n) {
+    while (n->stream_producer_) n = n->stream_producer_;
+    return n;
+  };
+  tf::Taskflow taskflow;
+  std::unordered_map<Node*, tf::Task> tasks;
+  std::atomic<size_t> run_count{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+
+  for (auto n : run_nodes) {
+    if (n->stream_producer_) continue;
+    tasks[n] = taskflow.emplace([this, n, &run_count, &failed, &error](){
+      // count this node as done however the task ends
+      struct ProgressGuard {
+        std::atomic<size_t>& done;
+        ~ProgressGuard() { ++done; }
+      } progress_guard{progress_done_};
+      if (failed) return;
+      // all parents have finished at this point, so the status tells us if all inputs received data
+      n->update_status();
+      if (n->status_ != GF_NODE_READY || !n->autorun) return;
+      try {
+        size_t signature = 0;
+        // the streamed outputs are empty after a run, so streaming producers are always processed
+        if (incremental && n->stream_consumers_.empty()) {
+          signature = n->compute_signature();
+          if (signature == n->run_signature_ && n->outputs_valid()) {
+            std::lock_guard<std::mutex> lock(log_mutex_);
+            std::cout << "S " << n->get_name() << "... unchanged\n";
+            return;
+          }
+          // outputs are appended to by some nodes, so they need to be empty before processing
+          n->clear_outputs();
+        }
+        // wait until the memory that this node and its streaming consumers need fits in the budget
+        size_t estimate_kb = n->estimate_memory_kb();
+        for (auto consumer : n->stream_consumers_) estimate_kb += consumer->estimate_memory_kb();
+        n->reserved_memory_kb_ = reserve_memory(estimate_kb);
+        struct MemoryGuard {
+          NodeManager& manager;
+          Node& n;
+          ~MemoryGuard() { 
+            manager.release_memory(n.reserved_memory_kb_); 
+            n.reserved_memory_kb_ = 0;
+          }
+        } memory_guard{*this, *n};
+        if (n->stream_consumers_.empty())
+          process_node(*n);
+        else
+          run_with_stream_consumers(*n, [this, n]() { process_node(*n); }, run_count);
         ++run_count;
+        n->run_signature_ = signature;
+        {
+          std::lock_guard<std::mutex> lock(log_mutex_);
+          std::cout << "P " << n->get_name() << "... " << n->get_metrics().wall_time_ms << "ms" << copied_bytes_note(*n) << "\n";
+        }
+        // children are scheduled by the task graph, so we only let them know there is new data
         n->propagate_outputs();
-//      } catch (const gfException& e) {
-//        std::cout << "ERROR: gfException -- " << e.what() << "\n" << std::flush;
-//        n->status_ = GF_NODE_READY;
-//      }
-      std::clock_t c_end = std::clock(); // CPU time
-      std::cout << 1000.0 * (c_end-c_start) / CLOCKS_PER_SEC << "ms\n";
+        release_consumed_inputs(*n);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        if (!failed) error = std::current_exception();
+        failed = true;
+      }
+    });
+  }
+  for (auto n : run_nodes) {
+    auto i = plan_index(*plan, *n);
+    for (auto c=plan->child_offsets[i]; c<plan->child_offsets[i+1]; ++c) {
+      auto child = plan->nodes[plan->children[c]];
+      if (child->stream_producer_ == n) continue;
+      auto parent_task = task_node(n), child_task = task_node(child);
+      if (parent_task != child_task)
+        tasks.at(parent_task).precede(tasks.at(child_task));
+    }
+  }
+
+  progress_total_ += run_nodes.size();
+
+  get_executor().run(taskflow).wait();
+  end_output_release();
+
+  for (auto n : run_nodes) {
+    n->stream_producer_ = nullptr;
+    n->stream_consumers_.clear();
+    n->stream_outputs_.clear();
+    for (auto& [name, iT] : n->input_terminals) {
+      if (iT->get_family() == GF_SINGLE_FEATURE)
+        static_cast<gfSingleFeatureInputTerminal*>(iT.get())->stream_batch_.reset();
     }
   }
+
+  if (error) std::rethrow_exception(error);
   return run_count;
 }
+bool NodeManager::plan_streaming(const std::vector<Node*>& run_nodes) {
+  auto is_vector_terminal = [](gfTerminal& t) {
+    return t.get_family() == GF_SINGLE_FEATURE && t.supports_multiple_elements();
+  };
+  // candidate consumers support streaming and read all their vector inputs, and nothing else, from one upstream node
+  std::unordered_set<Node*> in_run(run_nodes.begin(), run_nodes.end());
+  std::unordered_map<Node*, Node*> producers;
+  for (auto n : run_nodes) {
+    if (!n->supports_streaming() || !n->autorun) continue;
+    Node* producer = nullptr;
+    std::set<Node*> other_parents;
+    bool valid = true;
+    for (auto& [name, iT] : n->input_terminals) {
+      for (auto& oT : iT->get_connected_outputs()) {
+        if (!is_vector_terminal(*iT) || !is_vector_terminal(*oT)) {
+          other_parents.insert(&oT->get_parent());
+          continue;
+        }
+        if (producer && producer != &oT->get_parent())
+          valid = false;
+        producer = &oT->get_parent();
+      }
+    }
+    if (valid && producer && in_run.count(producer) && !other_parents.count(producer))
+      producers[n] = producer;
+  }
+  // an output can only be streamed if all inputs that are connected to it belong to candidates. 
+  // Drop the candidates that read from an output that can not be streamed until nothing changes
+  auto is_streamable = [&](gfOutputTerminal& oT) {
+    if (!is_vector_terminal(oT)) return false;
+    auto inputs = oT.get_connected_inputs();
+    for (auto& iT : inputs) {
+      if (!producers.count(&iT->get_parent()) || !is_vector_terminal(*iT))
+        return false;
+    }
+    return !inputs.empty();
+  };
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto it = producers.begin(); it != producers.end();) {
+      bool streamable = true;
+      for (auto& [name, iT] : it->first->input_terminals) {
+        for (auto& oT : iT->get_connected_outputs()) {
+          if (&oT->get_parent() == it->second)
+            streamable = streamable && is_streamable(*oT);
+        }
+      }
+      if (streamable) {
+        ++it;
+      } else {
+        it = producers.erase(it);
+        changed = true;
+      }
+    }
+  }
+  for (auto& [consumer, producer] : producers) {
+    consumer->stream_producer_ = producer;
+    if (producer->stream_consumers_.empty()) {
+      for (auto& [name, oT] : producer->output_terminals) {
+        if (is_streamable(*oT))
+          producer->stream_outputs_.push_back(static_cast<gfSingleFeatureOutputTerminal*>(oT.get()));
+      }
+    }
+    producer->stream_consumers_.push_back(consumer);
+  }
+
+  // a stream is processed by one task, so the other parents of its consumers must not depend on that task. Otherwise run without streaming
+  auto task_node = [](Node* n) {
+    while (n->stream_producer_) n = n->stream_producer_;
+    return n;
+  };
+  std::unordered_map<Node*, std::set<Node*>> task_children;
+  std::unordered_map<Node*, size_t> task_parent_count;
+  bool valid = true;
+  for (auto n : run_nodes) {
+    task_parent_count.emplace(task_node(n), 0);
+    for (auto& child : n->get_child_nodes()) {
+      if (!in_run.count(child.get()) || child->stream_producer_ == n) continue;
+      auto parent_task = task_node(n), child_task = task_node(child.get());
+      if (parent_task == child_task)
+        valid = false;
+      else if (task_children[parent_task].insert(child_task).second)
+        ++task_parent_count[child_task];
+    }
+  }
+  // check for cycles by visiting the tasks in topological order
+  std::queue<Node*> ready;
+  for (auto& [n, count] : task_parent_count) {
+    if (count == 0) ready.push(n);
+  }
+  size_t n_visited = 0;
+  while (!ready.empty()) {
+    auto n = ready.front();
+    ready.pop();
+    ++n_visited;
+    for (auto child : task_children[n]) {
+      if (--task_parent_count[child] == 0) ready.push(child);
+    }
+  }
+  if (!valid || n_visited != task_parent_count.size()) {
+    std::cout << "Streaming disabled, the streaming nodes depend on other nodes in their own stream\n";
+    for (auto n : run_nodes) {
+      n->stream_producer_ = nullptr;
+      n->stream_consumers_.clear();
+      n->stream_outputs_.clear();
+    }
+    return false;
+  }
+  return !producers.empty();
+}
+void NodeManager::run_with_stream_consumers(Node& n, std::function<void()> produce, std::atomic<size_t>& run_count) {
+  // consumers block on their channel, so they get their own thread instead of a worker from the task graph
+  std::vector<std::shared_ptr<StreamChannel>> channels;
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(n.stream_consumers_.size());
+  for (size_t i=0; i<n.stream_consumers_.size(); ++i) {
+    auto channel = std::make_shared<StreamChannel>(stream_buffer_size);
+    channels.push_back(channel);
+    threads.emplace_back([this, consumer=n.stream_consumers_[i], channel, &consumer_error=errors[i], &run_count]() {
+      try {
+        consume_stream(*consumer, *channel, run_count);
+      } catch (...) {
+        consumer_error = std::current_exception();
+        channel->abort();
+      }
+    });
+  }
+  n.stream_channels_ = channels;
+  std::exception_ptr error;
+  try {
+    produce();
+    // the elements that were pushed after the last emit_batch() call
+    n.emit_batch();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto& channel : channels) {
+    channel->close();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  n.stream_channels_.clear();
+  // a failing consumer also makes the producer fail, so report the consumer error
+  for (auto& consumer_error : errors) {
+    if (consumer_error) std::rethrow_exception(consumer_error);
+  }
+  if (error) std::rethrow_exception(error);
+}
+void NodeManager::consume_stream(Node& n, StreamChannel& channel, std::atomic<size_t>& run_count) {
+  std::vector<std::pair<gfSingleFeatureInputTerminal*, const gfOutputTerminal*>> streamed_inputs;
+  bool inputs_ready = true;
+  for (auto& [name, iT] : n.input_terminals) {
+    auto outputs = iT->get_connected_outputs();
+    if (outputs.size() == 1 && &outputs[0]->get_parent() == n.stream_producer_)
+      streamed_inputs.push_back({static_cast<gfSingleFeatureInputTerminal*>(iT.get()), outputs[0].get()});
+    else if (!iT->has_data())
+      inputs_ready = false;
+  }
+  size_t n_batches = 0;
+  double wall_time_ms = 0;
+  run_with_stream_consumers(n, [&]() {
+    std::shared_ptr<const StreamBatch> batch;
+    while (channel.pop(batch)) {
+      // keep taking batches if this node can not run, so that the producer is not blocked
+      if (!inputs_ready || !n.autorun) continue;
+      for (auto& [iT, oT] : streamed_inputs) {
+        iT->stream_batch_ = batch->at(oT);
+      }
+      process_node(n);
+      ++n_batches;
+      wall_time_ms += n.get_metrics().wall_time_ms;
+      n.emit_batch();
+    }
+    for (auto& [iT, oT] : streamed_inputs) {
+      iT->stream_batch_.reset();
+    }
+  }, run_count);
+  ++progress_done_;
+  if (n_batches == 0) return;
+  ++run_count;
+  {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    std::cout << "P " << n.get_name() << "... " << n_batches << " batches, " << wall_time_ms << "ms" << copied_bytes_note(n) << "\n";
+  }
+  n.propagate_outputs();
+}
+bool StreamChannel::push(std::shared_ptr<const StreamBatch> batch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_full_.wait(lock, [this]() { return batches_.size() < capacity_ || aborted_; });
+  if (aborted_) return false;
+  batches_.push(std::move(batch));
+  not_empty_.notify_one();
+  return true;
+}
+bool StreamChannel::pop(std::shared_ptr<const StreamBatch>& batch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_empty_.wait(lock, [this]() { return !batches_.empty() || closed_ || aborted_; });
+  if (aborted_ || batches_.empty()) return false;
+  batch = std::move(batches_.front());
+  batches_.pop();
+  not_full_.notify_one();
+  return true;
+}
+void StreamChannel::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  not_empty_.notify_all();
+}
+void StreamChannel::abort() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  aborted_ = true;
+  std::queue<std::shared_ptr<const StreamBatch>>().swap(batches_);
+  not_empty_.notify_all();
+  not_full_.notify_all();
+}
+template<typename F> bool NodeManager::start_background_run(F run_fn) {
+  if (running_.exchange(true))
+    return false;
+  if (run_thread_.joinable())
+    run_thread_.join();
+  // calls that are still queued refer to the data of the previous run, which may be cleared by this run
+  process_main_thread_calls();
+  progress_done_ = 0;
+  progress_total_ = 0;
+  {
+    std::lock_guard<std::mutex> lock(run_error_mutex_);
+    run_error_.clear();
+  }
+  run_thread_ = std::thread([this, run_fn]() {
+    try {
+      run_fn();
+    } catch (const std::exception& e) {
+      std::cout << "ERROR: " << e.what() << "\n";
+      std::lock_guard<std::mutex> lock(run_error_mutex_);
+      run_error_ = e.what();
+    }
+    running_ = false;
+  });
+  return true;
+}
+bool NodeManager::run_all_async(bool notify_children) {
+  return start_background_run([this, notify_children]() { run_all(notify_children); });
+}
+bool NodeManager::run_async(NodeHandle node, bool notify_children) {
+  return start_background_run([this, node, notify_children]() { run(*node, notify_children); });
+}
+void NodeManager::wait() {
+  if (run_thread_.joinable())
+    run_thread_.join();
+}
+std::string NodeManager::get_run_error() {
+  std::lock_guard<std::mutex> lock(run_error_mutex_);
+  return run_error_;
+}
+gfObjectId gfObject::create_id() {
+  static std::atomic<gfObjectId> next_id{1};
+  return next_id++;
+}
+void NodeManager::call_on_main_thread(Node& n, std::function<void()> fn) {
+  if (main_thread_id_ == std::thread::id() || main_thread_id_ == std::this_thread::get_id() || !n.requires_main_thread()) {
+    fn();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(main_thread_calls_mutex_);
+  main_thread_calls_.push({n.get_handle(), std::move(fn)});
+}
+size_t NodeManager::process_main_thread_calls() {
+  std::queue<std::pair<std::weak_ptr<Node>, std::function<void()>>> calls;
+  {
+    std::lock_guard<std::mutex> lock(main_thread_calls_mutex_);
+    std::swap(calls, main_thread_calls_);
+  }
+  size_t count = calls.size();
+  while (!calls.empty()) {
+    // skip calls for nodes that were removed in the mean time
+    if (auto n = calls.front().first.lock())
+      calls.front().second();
+    calls.pop();
+  }
+  return count;
+}
+NodeManager::~NodeManager() {
+  wait();
+}
 NodeHandle NodeManager::create_node(NodeRegisterHandle node_register, std::string type_name) {
   // add node through a node register
   std::string new_name = type_name + "-" + random_string(6);
@@ -475,6 +1649,7 @@ NodeHandle NodeManager::create_node(NodeRegisterHandle node_register, std::strin
     *this
   );
   nodes[new_name] = handle;
+  invalidate_execution_plan();
   return handle;
 }
 NodeHandle NodeManager::create_node(NodeRegisterHandle node_register, std::string type_name, std::pair<float,float> pos) {
@@ -484,11 +1659,23 @@ NodeHandle NodeManager::create_node(NodeRegisterHandle node_register, std::strin
 }
 void NodeManager::remove_node(NodeHandle node) {
   nodes.erase(node->get_name());
+  invalidate_execution_plan();
 }
 void NodeManager::clear() {
   nodes.clear();
+  invalidate_execution_plan();
   data_offset.reset();
+  data_offset_source_ = nullptr;
+  memory_budget_source_ = nullptr;
   global_flowchart_params.clear();
+  n_threads = 1;
+  incremental = false;
+  streaming = false;
+  stream_buffer_size = 4;
+  cache_dir.clear();
+  release_consumed_outputs = false;
+  memory_budget_kb = 0;
+  clear_trace();
 }
 bool NodeManager::name_node(NodeHandle node, std::string new_name) {
   // rename a node, ensure uniqueness of name, return true if it wasn't already used
@@ -510,11 +1697,61 @@ std::vector<NodeHandle> NodeManager::dump_nodes() {
   return node_dump;
 }
 
+arr3d NodeManager::get_data_offset(const arr3d& p) {
+  if (data_offset_source_) {
+    auto offset = data_offset_source_->get_data_offset(p);
+    std::lock_guard<std::mutex> lock(data_offset_mutex_);
+    data_offset = offset;
+    return offset;
+  }
+  std::lock_guard<std::mutex> lock(data_offset_mutex_);
+  if (!data_offset.has_value())
+    data_offset = p;
+  return *data_offset;
+}
+void NodeManager::share_data_offset(NodeManager& other_manager) {
+  std::lock_guard<std::mutex> lock(other_manager.data_offset_mutex_);
+  data_offset = other_manager.data_offset;
+  data_offset_source_ = &other_manager;
+}
+void NodeManager::align_offset(Geometry& geometry) {
+  geometry.rebase(get_data_offset(geometry.offset()));
+}
 void NodeManager::set_globals(const NodeManager& other_manager) {
   for (auto& [name, param] : other_manager.global_flowchart_params) {
     global_flowchart_params[name] = param;
   }
 }
+void NodeManager::copy_globals(const NodeManager& other_manager) {
+  for (auto& [name, param] : other_manager.global_flowchart_params) {
+    std::shared_ptr<Parameter> copy;
+    if (param->is_type(typeid(std::string))) {
+      copy = std::make_shared<ParameterByValue<std::string>>("", name, param->get_help());
+    } else if (param->is_type(typeid(float))) {
+      copy = std::make_shared<ParameterByValue<float>>(0, name, param->get_help());
+    } else if (param->is_type(typeid(int))) {
+      copy = std::make_shared<ParameterByValue<int>>(0, name, param->get_help());
+    } else if (param->is_type(typeid(bool))) {
+      copy = std::make_shared<ParameterByValue<bool>>(false, name, param->get_help());
+    } else {
+      // unknown type, share it like set_globals() does
+      global_flowchart_params[name] = param;
+      continue;
+    }
+    copy->copy_value_from(*param);
+    global_flowchart_params[name] = copy;
+  }
+}
+void NodeManager::copy_settings(const NodeManager& other_manager) {
+  data_offset = other_manager.data_offset;
+  n_threads = other_manager.n_threads;
+  incremental = other_manager.incremental;
+  cache_dir = other_manager.cache_dir;
+  streaming = other_manager.streaming;
+  stream_buffer_size = other_manager.stream_buffer_size;
+  release_consumed_outputs = other_manager.release_consumed_outputs;
+  memory_budget_kb = other_manager.memory_budget_kb;
+}
 
 void NodeManager::json_serialise(std::ostream& json_sstream) {
   json j;
@@ -530,11 +1767,24 @@ void NodeManager::json_serialise(std::ostream& json_sstream) {
       j["globals"][name] = {std::string("str"), param->as_json()};
     }
   }
+  j["settings"] = json::object();
+  j["settings"]["n_threads"] = n_threads;
+  j["settings"]["incremental"] = incremental;
+  j["settings"]["streaming"] = streaming;
+  j["settings"]["stream_buffer_size"] = stream_buffer_size;
+  j["settings"]["release_consumed_outputs"] = release_consumed_outputs;
+  j["settings"]["memory_budget_kb"] = memory_budget_kb;
+  if (!cache_dir.empty())
+    j["settings"]["cache_dir"] = cache_dir;
   j["nodes"] = json::object();
   for (auto& [name, node_handle] : nodes) {
     json n;
     n["type"] = {node_handle->node_register->get_name(), node_handle->get_type_name()};
     n["position"] = {node_handle->position[0], node_handle->position[1]};
+    if (node_handle->use_disk_cache)
+      n["use_disk_cache"] = true;
+    if (node_handle->memory_estimate_kb)
+      n["memory_estimate_kb"] = node_handle->memory_estimate_kb;
     for ( auto& [pname, pvalue] : node_handle->parameters ) {
       if (pvalue->has_master())
         n["parameters"][pname] = std::string("{{" + pvalue->get_master().lock()->get_label() + "}}");
@@ -543,10 +1793,9 @@ void NodeManager::json_serialise(std::ostream& json_sstream) {
     }
     for (const auto& [name, oTerm] : node_handle->output_terminals) {
       std::vector<std::pair<std::string, std::string>> connection_vec;
-      if(oTerm->get_connections().size() > 0) {
-        for (auto& conn : oTerm->get_connections()) {
-          if (auto iTerm = conn.lock())
-            connection_vec.push_back(std::make_pair(iTerm->get_parent().get_name(), iTerm->get_name()));
+      if(oTerm->connection_count() > 0) {
+        for (auto& iTerm : oTerm->get_connected_inputs()) {
+          connection_vec.push_back(std::make_pair(iTerm->get_parent().get_name(), iTerm->get_name()));
         }
         n["connections"][name] = connection_vec;
       }
@@ -558,6 +1807,8 @@ void NodeManager::json_serialise(std::ostream& json_sstream) {
     }
     for (const auto& [name, oTerm] : node_handle->output_terminals) {
       n["marked_outputs"][name] = oTerm->is_marked();
+      if (oTerm->get_keep_data())
+        n["keep_data_outputs"][name] = true;
     }
     
     j["nodes"][name] = n;
@@ -596,6 +1847,23 @@ std::vector<NodeHandle> NodeManager::json_unserialise(std::istream& json_sstream
       std::cout << "Unable to read global " << gname <<"\n";
     }
   }
+  if (j.count("settings")) {
+    auto& settings_j = j["settings"];
+    if (settings_j.count("n_threads"))
+      n_threads = settings_j["n_threads"].get<size_t>();
+    if (settings_j.count("incremental"))
+      incremental = settings_j["incremental"].get<bool>();
+    if (settings_j.count("streaming"))
+      streaming = settings_j["streaming"].get<bool>();
+    if (settings_j.count("stream_buffer_size"))
+      stream_buffer_size = settings_j["stream_buffer_size"].get<size_t>();
+    if (settings_j.count("release_consumed_outputs"))
+      release_consumed_outputs = settings_j["release_consumed_outputs"].get<bool>();
+    if (settings_j.count("memory_budget_kb"))
+      memory_budget_kb = settings_j["memory_budget_kb"].get<size_t>();
+    if (settings_j.count("cache_dir"))
+      cache_dir = settings_j["cache_dir"].get<std::string>();
+  }
   json nodes_j = j["nodes"];
   for (auto node_j : nodes_j.items()) {
     auto tt = node_j.value().at("type").get<std::array<std::string,2>>();
@@ -606,6 +1874,10 @@ std::vector<NodeHandle> NodeManager::json_unserialise(std::istream& json_sstream
       new_nodes.push_back(nhandle);
       std::string node_name = node_j.key();
       name_node(nhandle, node_name);
+      if (node_j.value().count("use_disk_cache"))
+        nhandle->use_disk_cache = node_j.value().at("use_disk_cache").get<bool>();
+      if (node_j.value().count("memory_estimate_kb"))
+        nhandle->memory_estimate_kb = node_j.value().at("memory_estimate_kb").get<size_t>();
 
       // set node parameters
       if (node_j.value().count("parameters")) {
@@ -643,6 +1915,11 @@ std::vector<NodeHandle> NodeManager::json_unserialise(std::istream& json_sstream
             nhandle->output_terminals.at(it.key())->set_marked(it.value().get<bool>());
           }
         }
+        if (node_j.value().count("keep_data_outputs")) {
+          for (auto& it : node_j.value().at("keep_data_outputs").items()) {
+            nhandle->output_terminals.at(it.key())->set_keep_data(it.value().get<bool>());
+          }
+        }
       } catch (const std::out_of_range& oor) {
         std::cout << "could not find one marked terminal\n";
       }
@@ -683,6 +1960,75 @@ std::vector<NodeHandle> NodeManager::json_unserialise(std::istream& json_sstream
   }
   return new_nodes;
 }
+std::vector<NodeHandle> NodeManager::clone_nodes(NodeManager& other_manager) {
+  // nodes that keep their name are added to nodes directly, without create_node()
+  invalidate_execution_plan();
+  std::vector<NodeHandle> new_nodes;
+  std::unordered_map<Node*, NodeHandle> cloned; // node in other_manager -> its clone in this manager
+  for (auto& [name, other_node] : other_manager.nodes) {
+    // keep the node name, unless it is already taken in this flowchart
+    NodeHandle nhandle;
+    if (nodes.count(name)) {
+      nhandle = create_node(other_node->node_register, other_node->type_name);
+    } else {
+      nhandle = other_node->node_register->create(name, other_node->type_name, *this);
+      nodes[name] = nhandle;
+    }
+    nhandle->position = other_node->position;
+    nhandle->autorun = other_node->autorun;
+    nhandle->use_disk_cache = other_node->use_disk_cache;
+    nhandle->memory_estimate_kb = other_node->memory_estimate_kb;
+
+    // set node parameters
+    for (auto& [pname, other_param] : other_node->parameters) {
+      auto param_it = nhandle->parameters.find(pname);
+      if (param_it == nhandle->parameters.end()) continue;
+      auto master = other_param->get_master().lock();
+      auto global_it = master ? global_flowchart_params.find(master->get_label()) : global_flowchart_params.end();
+      if (global_it != global_flowchart_params.end()) {
+        param_it->second->set_master(global_it->second);
+      } else {
+        // also keep the value of parameters whose global does not exist in this flowchart
+        param_it->second->copy_value_from(*other_param);
+      }
+    }
+    nhandle->post_parameter_load();
+
+    // set marked terminals
+    for (auto& [tname, other_iterm] : other_node->input_terminals) {
+      auto term_it = nhandle->input_terminals.find(tname);
+      if (term_it != nhandle->input_terminals.end())
+        term_it->second->set_marked(other_iterm->is_marked());
+    }
+    for (auto& [tname, other_oterm] : other_node->output_terminals) {
+      auto term_it = nhandle->output_terminals.find(tname);
+      if (term_it != nhandle->output_terminals.end()) {
+        term_it->second->set_marked(other_oterm->is_marked());
+        term_it->second->set_keep_data(other_oterm->get_keep_data());
+      }
+    }
+    cloned[other_node.get()] = nhandle;
+    new_nodes.push_back(nhandle);
+  }
+  // create connections
+  for (auto& [other_node, nhandle] : cloned) {
+    for (auto& [oname, other_oterm] : other_node->output_terminals) {
+      for (auto& other_iterm : other_oterm->get_connected_inputs()) {
+        auto target_it = cloned.find(&other_iterm->get_parent());
+        if (target_it == cloned.end()) continue;
+        auto& target = target_it->second;
+        auto iterm_it = target->input_terminals.find(other_iterm->get_name());
+        auto oterm_it = nhandle->output_terminals.find(oname);
+        if (iterm_it == target->input_terminals.end() || oterm_it == nhandle->output_terminals.end()) {
+          std::cout << "Could not clone connection from " << oname << " to " << other_iterm->get_name() << "\n";
+          continue;
+        }
+        oterm_it->second->connect(*iterm_it->second);
+      }
+    }
+  }
+  return new_nodes;
+}
 std::vector<NodeHandle> NodeManager::load_json(std::string filepath, bool strict) {
   std::ifstream ifs(filepath);
   return json_unserialise(ifs, strict);
@@ -696,16 +2042,20 @@ std::string NodeManager::substitute_globals(const std::string& textt) const {
     auto open = text.find("{{", start_pos);
     if (open==std::string::npos) break;
 
-    auto close = text.find("}}", start_pos);
+    auto close = text.find("}}", open+2);
     if (close==std::string::npos) break;
     open+=2;
     auto len = close-open;
     std::string global_name = text.substr(open, len);
-    if (global_flowchart_params.find(global_name) != global_flowchart_params.end())
-      if(global_flowchart_params.at(global_name)->is_type(typeid(std::string))) {
-        auto* global_val = static_cast<ParameterByValue<std::string>*>(global_flowchart_params.at(global_name).get());
-        text.replace(open-2, len+4, global_val->get());
-      }
+    // placeholders that are not a string global are left as they are
+    start_pos = close+2;
+    auto g = global_flowchart_params.find(global_name);
+    if (g != global_flowchart_params.end() && g->second->is_type(typeid(std::string))) {
+      auto& value = static_cast<ParameterByValue<std::string>*>(g->second.get())->get();
+      text.replace(open-2, len+4, value);
+      // do not substitute inside the value of the global
+      start_pos = open-2 + value.size();
+    }
   }
   return text;
 }
@@ -769,10 +2119,9 @@ void geoflow::disconnect(gfTerminal& t1, gfTerminal& t2) {
 //   return detect_loop(oT, iT);
 // }
 bool geoflow::detect_loop(gfTerminal& outputT, gfTerminal& inputT) {
-  auto node = inputT.get_parent().get_handle();
-  std::queue<std::shared_ptr<Node>> nodes_to_check;
-  std::set<std::shared_ptr<Node>> visited;
-  nodes_to_check.push(node);
+  std::queue<Node*> nodes_to_check;
+  std::unordered_set<gfObjectId> visited;
+  nodes_to_check.push(&inputT.get_parent());
   bool loop_detected=false;
   while (!nodes_to_check.empty()) {
     auto n = nodes_to_check.front();
@@ -783,13 +2132,10 @@ bool geoflow::detect_loop(gfTerminal& outputT, gfTerminal& inputT) {
         loop_detected=true;
         return;
       }
-      for (auto& c :oT.get_connections()) {
-        if (auto iT = c.lock()) {
-          auto child_node = iT->get_parent().get_handle();
-          if (visited.count(child_node)==0) {
-            visited.insert(child_node);
-            nodes_to_check.push(child_node);
-          }
+      for (auto iT : oT.get_connected_input_ptrs()) {
+        auto child_node = &iT->get_parent();
+        if (visited.insert(child_node->get_id()).second) {
+          nodes_to_check.push(child_node);
         }
       }
     });
@@ -802,8 +2148,7 @@ geoflow::ConnectionList geoflow::dump_connections(std::vector<NodeHandle> node_v
   ConnectionList connections;
   for (auto& node : node_vec) {
     for (auto& output_term : node->output_terminals) {
-      for (auto& input_term : output_term.second->get_connections()) {
-        auto iT = input_term.lock();
+      for (auto& iT : output_term.second->get_connected_inputs()) {
         auto oT = output_term.second;
         connections.push_back(std::make_tuple(
           node->get_name(), 
@@ -20,6 +20,7 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <cstdint>
 #include <functional>
 #include <any>
 #include <optional>
@@ -31,6 +32,12 @@
 #include <queue>
 #include <typeinfo>
 #include <typeindex>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <atomic>
 
 #include <iostream>
 #include <sstream>
@@ -38,14 +45,26 @@
 #include "common.hpp"
 #include "parameters.hpp"
 
+namespace tf {
+  class Executor;
+}
+
 namespace geoflow {
 
+  // identifies a node or terminal, unique within the process and stable for the lifetime of the object
+  typedef size_t gfObjectId;
+
   class gfObject {
+    private:
+    const gfObjectId id_;
+    static gfObjectId create_id();
+
     protected:
     std::string name_;
 
     public:
-    gfObject(std::string name) : name_(name) {};
+    gfObject(std::string name) : id_(create_id()), name_(name) {};
+    gfObjectId get_id() const { return id_; };
     const std::string& get_name() const { return name_; };
     const std::string* get_name_ptr() const { return &name_; };
   };
@@ -77,6 +96,73 @@ namespace geoflow {
   class gfOutputTerminal;
   class gfSingleFeatureOutputTerminal;
 
+  // non-owning view on contiguous terminal data
+  template<typename T> class gfSpan {
+    T* data_;
+    size_t size_;
+    public:
+    gfSpan(T* data, size_t size) : data_(data), size_(size) {};
+    T* data() const { return data_; };
+    size_t size() const { return size_; };
+    bool empty() const { return size_==0; };
+    T& operator[](size_t i) const { return data_[i]; };
+    T* begin() const { return data_; };
+    T* end() const { return data_+size_; };
+  };
+
+  // shallow estimate of the number of bytes used by a value of type T, containers are counted recursively by their 
+  // elements. Other members of a container type (eg. the interior rings of a LinearRing or the attributes of a geometry 
+  // collection) and data behind pointers are not counted
+  template<typename T, typename = void> struct gfDataSize {
+    static size_t bytes(const T&) { return sizeof(T); }
+  };
+  template<typename T> struct gfDataSize<T, std::void_t<typename T::value_type, decltype(std::declval<const T&>().size())>> {
+    static size_t bytes(const T& value) { 
+      using V = typename T::value_type;
+      if constexpr (std::is_trivially_copyable<V>::value) {
+        return sizeof(T) + value.size() * sizeof(V);
+      } else {
+        size_t n_bytes = sizeof(T);
+        for (auto& v : value) n_bytes += gfDataSize<V>::bytes(v);
+        return n_bytes;
+      }
+    }
+  };
+
+  // Typed storage for the elements of a vector output terminal. Keeps all elements in one contiguous buffer instead of boxing each element in a std::any
+  class gfColumnBase {
+    public:
+    virtual ~gfColumnBase() {};
+    virtual std::type_index get_type() const = 0;
+    virtual size_t size() const = 0;
+    virtual void clear() = 0;
+    virtual std::any get_any(size_t i) const = 0;
+    virtual void push_back_any(const std::any& value) = 0;
+    // moves the element out of value
+    virtual void push_back_any(std::any&& value) = 0;
+    // new empty column with the same element type
+    virtual std::unique_ptr<gfColumnBase> create_empty() const = 0;
+  };
+  template<typename T> class gfColumn : public gfColumnBase {
+    public:
+    std::vector<T> data;
+    std::type_index get_type() const { return typeid(T); };
+    size_t size() const { return data.size(); };
+    void clear() { data.clear(); };
+    std::any get_any(size_t i) const { return data[i]; };
+    void push_back_any(const std::any& value) { 
+      if (!value.has_value())
+        throw gfException("Can not store an empty value in a terminal with typed storage");
+      data.push_back(std::any_cast<const T&>(value));
+    };
+    void push_back_any(std::any&& value) { 
+      if (!value.has_value())
+        throw gfException("Can not store an empty value in a terminal with typed storage");
+      data.push_back(std::move(std::any_cast<T&>(value)));
+    };
+    std::unique_ptr<gfColumnBase> create_empty() const { return std::make_unique<gfColumn<T>>(); };
+  };
+
   enum gfIO {GF_IN, GF_OUT};
   // enum gfTerminalFamily {GF_UNKNOWN, GF_BASIC, GF_VECTOR, GF_POLY};
   enum gfTerminalFamily {GF_UNKNOWN, GF_SINGLE_FEATURE, GF_MULTI_FEATURE};
@@ -113,13 +199,25 @@ namespace geoflow {
     friend class Node;
   };
 
+  // Entry in the flat connection lists of the terminals. The raw pointer is used when the flowchart runs, it stays valid
+  // because terminals remove themselves from the lists of their peers when they are destroyed. The weak_ptr backs the
+  // weak_ptr based API, eg. gfOutputTerminal::get_connections()
+  template<typename T> struct gfConnection {
+    gfObjectId id;
+    T* terminal;
+    std::weak_ptr<T> ptr;
+  };
+
   class gfInputTerminal : public gfTerminal, public std::enable_shared_from_this<gfInputTerminal> {
     private:
     bool is_optional_;
 
     protected:
     virtual void clear();
-    virtual void update_on_receive(bool queue) = 0;
+    virtual void update_on_receive() = 0;
+    // combined version of the connected output terminal(s), changes whenever the incoming data changes
+    virtual size_t get_input_version() const = 0;
+    virtual std::vector<std::shared_ptr<gfOutputTerminal>> get_connected_outputs() const = 0;
     virtual void connect_output(gfOutputTerminal& output_term) = 0;
     virtual void disconnect_output(gfOutputTerminal& output_term) = 0;
 
@@ -140,18 +238,32 @@ namespace geoflow {
     const gfIO get_side() { return GF_IN; };
     bool is_optional() { return is_optional_; };
     virtual size_t size() const = 0;
+    // true once all connected output terminals published their data, safe to call while the flowchart runs (eg. from 
+    // the GUI thread). Unlike has_data() this ignores the batches of a streaming producer
+    bool is_published() const;
 
     friend class gfOutputTerminal;
     friend class gfSingleFeatureOutputTerminal;
     friend class Node;
+    friend class NodeManager;
   };
 
   class gfSingleFeatureInputTerminal : public gfInputTerminal {
     protected:
     std::weak_ptr<gfOutputTerminal> connected_output_;
-    void update_on_receive(bool queue);
+    // same terminal as connected_output_, for the checks that do not need to extend its lifetime
+    gfOutputTerminal* connected_output_ptr_ = nullptr;
+    // while a streaming consumer processes a batch, the data is read from the batch instead of the connected output
+    std::shared_ptr<gfSingleFeatureOutputTerminal> stream_batch_;
+    // the terminal that holds the data, ie. stream_batch_ or the connected output
+    std::shared_ptr<gfSingleFeatureOutputTerminal> get_data_source() const;
+    void update_on_receive();
     void connect_output(gfOutputTerminal& output_term);
     void disconnect_output(gfOutputTerminal& output_term);
+    size_t get_input_version() const;
+    std::vector<std::shared_ptr<gfOutputTerminal>> get_connected_outputs() const;
+    // adds to Node::copied_bytes_ of the parent node
+    void count_copied_bytes(size_t n_bytes);
 
     public:
     using gfInputTerminal::gfInputTerminal;
@@ -164,15 +276,25 @@ namespace geoflow {
 
     // single element
     // const gfTerminalFamily get_family() { return GF_BASIC; };
+    // returns a copy unless T is a reference type, eg. get<PointCollection&>(). Prefer get_ref<T>() for large data
     template<typename T> const T get();
+    // read-only access to the data in the connected output without copying
+    template<typename T> const T& get_ref();
 
     // multi element (vector)
     const gfTerminalFamily get_family() { return GF_SINGLE_FEATURE; };
     template<typename T> const T get(size_t i);
+    template<typename T> const T& get_ref(size_t i);
+    // zero-copy access to all elements, only possible if the connected output uses typed storage (see Node::add_vector_output<T>)
+    template<typename T> gfSpan<const T> get_span() const;
+    std::any get_any(size_t i) const;
+    bool is_contiguous() const;
+    // not available if the connected output uses typed storage
     const std::vector<std::any>& get_data_vec() const;
     size_t size() const;
 
     friend class gfSingleFeatureOutputTerminal;
+    friend class NodeManager;
   };
 
 
@@ -180,12 +302,31 @@ namespace geoflow {
 
   class gfOutputTerminal : public gfTerminal, public std::enable_shared_from_this<gfOutputTerminal> {
     protected:
-    InputConnectionSet connections_;
-    bool is_touched_=false;
+    std::vector<gfConnection<gfInputTerminal>> connections_;
+    // guards connections_, propagation only takes a shared lock
+    mutable std::shared_mutex connections_mutex_;
+    std::atomic<bool> is_touched_{false};
+    // Set with release semantics after the data is written (see publish()) and read with acquire semantics in 
+    // is_published(). A thread that sees is_published()==true therefore also sees the data itself
+    std::atomic<bool> has_data_{false};
+    // incremented every time the data in this terminal is touched or cleared
+    size_t version_=0;
+    // never release the data of this terminal, see NodeManager::release_consumed_outputs
+    bool keep_data_=false;
+    // number of connected inputs that still need to read the data in the current run. Only counted for terminals whose 
+    // data may be released, 0 otherwise
+    std::atomic<size_t> pending_consumers_{0};
 
     std::set<NodeHandle> get_child_nodes();
+    void remove_connection(gfObjectId input_id);
+    // free the data after all consumers read it. Unlike clear() this keeps the sub terminals of a multi feature output, 
+    // because connected multi feature inputs refer to them
+    void release();
     virtual void propagate();
     virtual void clear() = 0;
+    // check for data without synchronisation, only to be used by the thread that writes the data
+    virtual bool data_available() const = 0;
+    void publish() { has_data_.store(data_available(), std::memory_order_release); };
 
     public:
     gfOutputTerminal(Node& parent_gnode, std::string name, std::initializer_list<std::type_index> types, bool supports_multiple_elements) 
@@ -194,10 +335,20 @@ namespace geoflow {
       : gfTerminal(parent_gnode, types, name, supports_multiple_elements) {}
     ~gfOutputTerminal();
     std::weak_ptr<gfOutputTerminal>  get_ptr(){ return weak_from_this(); }
-    const InputConnectionSet& get_connections();
+    // copy of the connections as a set of weak_ptrs, kept for compatibility. Prefer get_connected_inputs()
+    InputConnectionSet get_connections() const;
+    std::vector<std::shared_ptr<gfInputTerminal>> get_connected_inputs() const;
+    // the connected input terminals without taking ownership, only valid as long as the connected nodes are not removed
+    std::vector<gfInputTerminal*> get_connected_input_ptrs() const;
+    size_t connection_count() const;
     const gfIO get_side() { return GF_OUT; };
     
-    bool has_connection() { return connections_.size()>0; };
+    bool has_connection() { return connection_count()>0; };
+    // true if this terminal holds data, including data that was not propagated yet. Only to be used by the thread that 
+    // writes the data or when no run is in progress, other threads use is_published()
+    bool has_data() const { return data_available(); };
+    // true once the data was published by propagate(), safe to call while the flowchart runs
+    bool is_published() const { return has_data_.load(std::memory_order_acquire); };
     bool is_compatible(gfInputTerminal& input_terminal);
     void connect(gfInputTerminal& in);
     void disconnect(gfInputTerminal& in);
@@ -205,10 +356,21 @@ namespace geoflow {
     virtual size_t size() const=0;
     void set_type(std::type_index type) {types_ = {type}; }
 
-    void touch() { is_touched_=true; };
-    bool is_touched() { return is_touched_; };
+    void touch() { 
+      is_touched_.store(true, std::memory_order_release);
+      ++version_; 
+      publish();
+    };
+    bool is_touched() { return is_touched_.load(std::memory_order_acquire); };
+    // identifies the current state of the data in this terminal, used to detect changed inputs in incremental runs
+    virtual size_t get_version() const;
+
+    // opt out of NodeManager::release_consumed_outputs, eg. to inspect the data after a run
+    void set_keep_data(bool keep_data) { keep_data_ = keep_data; };
+    bool get_keep_data() const { return keep_data_; };
 
     friend class Node;
+    friend class NodeManager;
     friend class gfInputTerminal;
     friend class gfGroupOutputTerminal;
     friend class gfSingleFeatureInputTerminal;
@@ -220,6 +382,31 @@ namespace geoflow {
     // std::any data_;
     private:
     std::vector<std::any> data_;
+    // typed storage, only used if the element type was fixed with use_column<T>(). data_ is unused in that case
+    std::unique_ptr<gfColumnBase> column_;
+    // computes the size of the stored data for the element type that was last stored through the typed API
+    size_t (*data_bytes_)(const gfSingleFeatureOutputTerminal&) = nullptr;
+
+    template<typename T> static size_t data_bytes(const gfSingleFeatureOutputTerminal& term) {
+      if constexpr (std::is_trivially_copyable<T>::value) {
+        return term.size() * sizeof(T);
+      } else {
+        size_t n_bytes = 0;
+        for (size_t i=0; i<term.size(); ++i) {
+          if (term.column_ || term.data_[i].type() == typeid(T))
+            n_bytes += gfDataSize<T>::bytes(term.get<const T&>(i));
+          else
+            n_bytes += sizeof(std::any);
+        }
+        return n_bytes;
+      }
+    }
+
+    template<typename T> gfColumn<T>& column() const {
+      if (column_->get_type() != typeid(T))
+        throw gfException("illegal type for gfSingleFeatureOutputTerminal");
+      return *static_cast<gfColumn<T>*>(column_.get());
+    }
     
     protected:
     // void clear();
@@ -228,55 +415,161 @@ namespace geoflow {
     public:
     using gfOutputTerminal::gfOutputTerminal;
     const std::type_index& get_type() const { return types_[0]; };
+    void set_type(std::type_index type) {
+      types_ = {type};
+      if (column_ && column_->get_type() != type)
+        column_.reset();
+    }
+
+    // store elements in one contiguous buffer of type T instead of a vector of std::any
+    template<typename T> void use_column() {
+      static_assert(!std::is_same<T, bool>::value, "std::vector<bool> can not be used for typed terminal storage");
+      if (!accepts_type(typeid(T)))
+        throw gfException("illegal type for gfSingleFeatureOutputTerminal");
+      data_.clear();
+      column_ = std::make_unique<gfColumn<T>>();
+      data_bytes_ = &data_bytes<T>;
+    }
+    bool is_contiguous() const { return column_ != nullptr; };
+    // move all elements to a new terminal and leave this terminal empty, used to hand batches to streaming consumers
+    std::shared_ptr<gfSingleFeatureOutputTerminal> take_batch();
 
     // single element
     const gfTerminalFamily get_family() { return GF_SINGLE_FEATURE; };
-    bool has_data() const;
+    bool data_available() const;
     void push_back_any(const std::any& data) {
-      data_.push_back(data);
+      if (column_)
+        column_->push_back_any(data);
+      else
+        data_.push_back(data);
+    }
+    // moves data into the terminal, eg. the std::any returned by get_any()
+    void push_back_any(std::any&& data) {
+      if (column_)
+        column_->push_back_any(std::move(data));
+      else
+        data_.push_back(std::move(data));
     }
-    template<typename T> void push_back(T data) {
+    template<typename T> void push_back(const T& data) {
+      emplace_back<std::decay_t<T>>(data);
+    };
+    // moves data into the terminal. Only enabled for rvalues, lvalues go to the overload above
+    template<typename T, typename = std::enable_if_t<!std::is_lvalue_reference<T>::value>> void push_back(T&& data) {
+      emplace_back<std::decay_t<T>>(std::move(data));
+    };
+    // construct a new element in place from args, returns a reference to the stored element
+    template<typename T, typename... Args> T& emplace_back(Args&&... args) {
       if(!accepts_type(typeid(T)))
         throw gfException("illegal type for gfSingleFeatureOutputTerminal");
-      data_.push_back(std::move(data));
+      data_bytes_ = &data_bytes<T>;
+      T* element = nullptr;
+      // bool elements are never stored in a column, see use_column()
+      if constexpr (!std::is_same<T, bool>::value) {
+        if (column_)
+          element = &column<T>().data.emplace_back(std::forward<Args>(args)...);
+      }
+      if (!element)
+        element = &std::any_cast<T&>(data_.emplace_back(std::in_place_type<T>, std::forward<Args>(args)...));
+      // publish only after the element is stored
       touch();
+      return *element;
+    };
+    template<typename T> std::decay_t<T>& set(const T& data){
+      return emplace<std::decay_t<T>>(data);
+    };
+    template<typename T, typename = std::enable_if_t<!std::is_lvalue_reference<T>::value>> std::decay_t<T>& set(T&& data){
+      return emplace<std::decay_t<T>>(std::move(data));
     };
-    template<typename T> T& set(T data){
+    // replace the data with a single element that is constructed in place, eg. 
+    //   auto& points = output("points").emplace<PointCollection>();
+    //   points.push_back(...);
+    template<typename T, typename... Args> T& emplace(Args&&... args){
       if(!accepts_type(typeid(T)))
         throw gfException("illegal type for gfSingleFeatureOutputTerminal");
-      data_.clear();
-      push_back(data);
-      return std::any_cast<T&>(data_[0]);
+      clear_data();
+      return emplace_back<T>(std::forward<Args>(args)...);
     };
     void set_from_any(const std::any& data) {
-      data_.clear();
-      data_.resize(1);
-      data_[0] = data;
+      clear_data();
+      push_back_any(data);
+      touch();
+    }
+    void set_from_any(std::any&& data) {
+      clear_data();
+      push_back_any(std::move(data));
       touch();
     }
     void operator=(const std::vector<std::any>& data_vec) {
-      data_.clear();
-      data_ = data_vec;
+      clear_data();
+      if (column_) {
+        for (auto& data : data_vec)
+          column_->push_back_any(data);
+      } else {
+        data_ = data_vec;
+      }
       touch();
     }
 
     bool has_value(size_t i=0) {
-      return !data_[i].has_value();
+      if (column_)
+        return i < column_->size();
+      return data_[i].has_value();
     }
 
     // multi element
-    size_t size() const { return data_.size(); };
+    size_t size() const { return column_ ? column_->size() : data_.size(); };
+    // estimate of the memory used by the data in this terminal
+    size_t get_data_bytes() const {
+      if (data_bytes_) return data_bytes_(*this);
+      return size() * sizeof(std::any);
+    }
     template<typename T>void resize(size_t n) {
+      if (column_)
+        return column<T>().data.resize(n, T());
       return data_.resize(n, T());
     };
-    std::any& get_data() { return data_[0]; };
-    const std::any& get_data() const { return data_[0]; };
-    std::vector<std::any>& get_data_vec() { return data_; };
-    const std::vector<std::any>& get_data_vec() const { return data_; };
+    std::any& get_data() { return get_data_vec()[0]; };
+    const std::any& get_data() const { return get_data_vec()[0]; };
+    std::vector<std::any>& get_data_vec() { 
+      if (column_)
+        throw gfException("terminal " + get_name() + " uses typed storage, its data is not available as std::any");
+      return data_; 
+    };
+    const std::vector<std::any>& get_data_vec() const { 
+      if (column_)
+        throw gfException("terminal " + get_name() + " uses typed storage, its data is not available as std::any");
+      return data_; 
+    };
+    std::any get_any(size_t i) const {
+      return column_ ? column_->get_any(i) : data_[i];
+    }
+    // direct access to the typed storage, eg. to reserve memory or fill it in place. The data is published when the 
+    // node propagates its outputs
+    template<typename T> std::vector<T>& get_column() {
+      if (!column_)
+        throw gfException("terminal " + get_name() + " does not store its data contiguously");
+      return column<T>().data;
+    }
+    template<typename T> gfSpan<T> get_span() {
+      if (!column_)
+        throw gfException("terminal " + get_name() + " does not store its data contiguously");
+      auto& vec = column<T>().data;
+      return gfSpan<T>(vec.data(), vec.size());
+    }
+    template<typename T> gfSpan<const T> get_span() const {
+      if (!column_)
+        throw gfException("terminal " + get_name() + " does not store its data contiguously");
+      const auto& vec = column<T>().data;
+      return gfSpan<const T>(vec.data(), vec.size());
+    }
     template<typename T> T get(size_t i) { 
+      if (column_)
+        return column<std::remove_cv_t<std::remove_reference_t<T>>>().data[i];
       return std::any_cast<T>(data_[i]); 
     };
     template<typename T> const T get(size_t i) const { 
+      if (column_)
+        return column<std::remove_cv_t<std::remove_reference_t<T>>>().data[i];
       return std::any_cast<T>(data_[i]); 
     };
     template<typename T> T get() { 
@@ -286,19 +579,37 @@ namespace geoflow {
       return get<T>(0); 
     };
 
+    private:
+    void clear_data() {
+      data_.clear();
+      if (column_) column_->clear();
+    }
 
     friend class gfSingleFeatureInputTerminal;
     friend class gfMultiFeatureOutputTerminal;
   };
 
   template<typename T>const T gfSingleFeatureInputTerminal::get(size_t i) {
-    auto output_term = connected_output_.lock();
-    auto sot = (gfSingleFeatureOutputTerminal*)(output_term.get());
-    return sot->get<T>(i);
+#ifndef NDEBUG
+    // keep track of how much data is copied out of the terminal, see Node::get_copied_bytes()
+    if constexpr (!std::is_reference<T>::value)
+      count_copied_bytes(gfDataSize<std::remove_cv_t<T>>::bytes(get_ref<std::remove_cv_t<T>>(i)));
+#endif
+    return get_data_source()->get<T>(i);
   }
   template<typename T> const T gfSingleFeatureInputTerminal::get() {
     return get<T>(0);
   };
+  template<typename T>const T& gfSingleFeatureInputTerminal::get_ref(size_t i) {
+    return get_data_source()->get<const T&>(i);
+  }
+  template<typename T> const T& gfSingleFeatureInputTerminal::get_ref() {
+    return get_ref<T>(0);
+  };
+  template<typename T> gfSpan<const T> gfSingleFeatureInputTerminal::get_span() const {
+    std::shared_ptr<const gfSingleFeatureOutputTerminal> source = get_data_source();
+    return source->get_span<T>();
+  };
 
   typedef std::set<std::weak_ptr<gfOutputTerminal>, std::owner_less<std::weak_ptr<gfOutputTerminal>>> OutputConnectionSet;
   
@@ -315,12 +626,14 @@ namespace geoflow {
 
     protected:
     // void clear();
-    OutputConnectionSet connected_outputs_;
+    std::vector<gfConnection<gfOutputTerminal>> connected_outputs_;
     
     void clear();
-    void update_on_receive(bool queue);
+    void update_on_receive();
     void connect_output(gfOutputTerminal& output_term);
     void disconnect_output(gfOutputTerminal& output_term);
+    size_t get_input_version() const;
+    std::vector<std::shared_ptr<gfOutputTerminal>> get_connected_outputs() const;
     
     public:
     using gfInputTerminal::gfInputTerminal;
@@ -356,7 +669,11 @@ namespace geoflow {
     public:
     using gfOutputTerminal::gfOutputTerminal;
     const gfTerminalFamily get_family() { return GF_MULTI_FEATURE; };
-    bool has_data() const;
+    size_t get_version() const;
+    // checks the data of the sub terminals, not their published state
+    bool data_available() const;
+    // publishes the sub terminals before this terminal, so that they are ready once this terminal has data
+    void propagate() override;
     size_t size() const;
 
     // note these 2 are almost the same now:
@@ -372,7 +689,10 @@ namespace geoflow {
       clear();
       for(const auto& iterm : gfMFInput.sub_terminals()) {
         auto& oterm = add_vector(iterm->get_name(), iterm->get_type());
-        oterm = iterm->get_data_vec();
+        for (size_t i=0; i<iterm->size(); ++i) {
+          oterm.push_back_any(iterm->get_any(i));
+        }
+        oterm.touch();
       }
       touch();
     }
@@ -400,6 +720,45 @@ namespace geoflow {
     static const gfTerminalFamily value = GF_MULTI_FEATURE;
   };
 
+  // profiling information of a node, updated by NodeManager every time the node is processed
+  struct NodeMetrics {
+    size_t calls = 0;
+    // wall clock and CPU time of the last run. CPU time is measured for the thread that processed the node
+    double wall_time_ms = 0;
+    double cpu_time_ms = 0;
+    // summed over all runs
+    double total_wall_time_ms = 0;
+    double total_cpu_time_ms = 0;
+    // increase of the peak resident set size of the process during the last run. Includes the memory use of nodes that ran concurrently
+    long peak_rss_delta_kb = 0;
+    // estimate of the size of the data in each output terminal after the last run
+    std::map<std::string, size_t> output_bytes;
+  };
+
+  // the batches that a streaming producer emitted for each of its streamed outputs, see Node::emit_batch()
+  typedef std::unordered_map<const gfOutputTerminal*, std::shared_ptr<gfSingleFeatureOutputTerminal>> StreamBatch;
+
+  // bounded queue of batches between a streaming producer and one consumer. push() blocks while the queue is full, 
+  // so a fast producer can not get further ahead of its consumer than the capacity of the channel
+  class StreamChannel {
+    std::mutex mutex_;
+    std::condition_variable not_empty_, not_full_;
+    std::queue<std::shared_ptr<const StreamBatch>> batches_;
+    size_t capacity_;
+    bool closed_=false, aborted_=false;
+
+    public:
+    StreamChannel(size_t capacity) : capacity_(std::max(capacity, size_t(1))) {};
+    // returns false if the consumer aborted
+    bool push(std::shared_ptr<const StreamBatch> batch);
+    // returns false once the channel is closed and empty, or aborted
+    bool pop(std::shared_ptr<const StreamBatch>& batch);
+    // no more batches will be pushed
+    void close();
+    // the consumer failed, unblocks and fails the producer
+    void abort();
+  };
+
   class Node : public std::enable_shared_from_this<Node>, public gfObject {
     private:
     template<typename T> T& add_input(std::string name, std::initializer_list<std::type_index> types, bool is_optional, bool supports_multiple_elements) {
@@ -439,22 +798,22 @@ namespace geoflow {
       if (input_terminals.find(term_name) == input_terminals.end()) {
         throw gfException("No such input terminal - \""+term_name+"\" in " + get_name());
       }
-      if (input_terminals[term_name]->get_family() != get_family<T>::value) {
+      if (input_terminals.at(term_name)->get_family() != get_family<T>::value) {
         throw gfException("Illegal terminal down cast - \""+term_name+"\" in " + get_name());
       }
         
-      auto input_term = (T*) (input_terminals[term_name].get());
+      auto input_term = (T*) (input_terminals.at(term_name).get());
       return *input_term;
     }
     template<typename T> T& output(std::string term_name) {
       if (output_terminals.find(term_name) == output_terminals.end()) {
         throw gfException("No such output terminal - \""+term_name+"\" in " + get_name());
       }
-      if (output_terminals[term_name]->get_family() != get_family<T>::value) {
+      if (output_terminals.at(term_name)->get_family() != get_family<T>::value) {
         throw gfException("Illegal terminal down cast - \""+term_name+"\" in " + get_name());
       }
 
-      auto output_term = (T*) (output_terminals[term_name].get());
+      auto output_term = (T*) (output_terminals.at(term_name).get());
       return *output_term;
     }
 
@@ -470,6 +829,11 @@ namespace geoflow {
 
     ParameterMap parameters;
     bool autorun = true;
+    // restore the outputs from the NodeManager::cache_dir if this node was processed before with the same parameters and upstream nodes
+    bool use_disk_cache = false;
+    // memory in kB that processing this node needs, see NodeManager::memory_budget_kb. Raised automatically to the largest
+    // peak_rss_delta_kb or output size measured in a run, 0 if unknown
+    size_t memory_estimate_kb = 0;
     arr2f position;
 
     Node(NodeRegisterHandle node_register, NodeManager& manager, std::string type_name, std::string node_name): node_register(node_register), manager(manager), type_name(type_name), gfObject(node_name) {};
@@ -507,7 +871,20 @@ namespace geoflow {
       }
     }
 
-    gfNodeStatus status_ = GF_NODE_WAITING;
+    std::atomic<gfNodeStatus> status_{GF_NODE_WAITING};
+    // serialises on_receive()/on_clear() calls and input terminal bookkeeping when several parents finish at the same time
+    std::recursive_mutex receive_mutex_;
+    // hash of the parameters and input versions this node was last processed with in an incremental run, 0 if unknown
+    size_t run_signature_ = 0;
+    // key of the cached results in NodeManager::cache_dir, computed from the node type, the parameters and the cache keys of the upstream nodes. 0 if unknown
+    uint64_t cache_key_ = 0;
+    NodeMetrics metrics_;
+    const NodeMetrics& get_metrics() const { return metrics_; };
+    // lower bound for the bytes copied out of the single feature input terminals by get<T>() during the last run of this 
+    // node, using the shallow estimate of gfDataSize. Only counted when NDEBUG is not defined (this includes the default 
+    // CMake build type). get<T>() on the sub terminals of a multi feature input is not counted
+    size_t copied_bytes_ = 0;
+    size_t get_copied_bytes() const { return copied_bytes_; };
 
     gfSingleFeatureInputTerminal& add_input(std::string name, std::type_index type, bool is_optional=false) {
       return add_input<gfSingleFeatureInputTerminal>(name, {type}, is_optional, false);
@@ -543,6 +920,12 @@ namespace geoflow {
     gfSingleFeatureOutputTerminal& add_vector_output(std::string name, std::type_index type) {
       return add_output<gfSingleFeatureOutputTerminal>(name, {type}, true);
     };
+    // vector output that stores its elements of type T in one contiguous buffer
+    template<typename T> gfSingleFeatureOutputTerminal& add_vector_output(std::string name) {
+      auto& term = add_output<gfSingleFeatureOutputTerminal>(name, {typeid(T)}, true);
+      term.template use_column<T>();
+      return term;
+    };
     gfMultiFeatureOutputTerminal& add_poly_output(std::string name, std::initializer_list<std::type_index> types) {
       return add_output<gfMultiFeatureOutputTerminal>(name, types, true);
     };
@@ -579,10 +962,17 @@ namespace geoflow {
     NodeHandle get_handle(){ return shared_from_this(); };
     WeakNodeHandle get_weak_handle(){ return shared_from_this(); };
 
-    bool queue();
     bool update_status();
     void propagate_outputs();
     void notify_children();
+    // hash of everything that determines the result of process(): the node type, the parameter values (after substituting globals) and the versions of the input data
+    size_t compute_signature() const;
+    // true if every output terminal holds the result of a previous run
+    bool outputs_valid();
+    // clear the outputs of this node and the input terminals connected to them, without going further downstream
+    void clear_outputs();
+    // 0 if the key of an upstream node is unknown
+    uint64_t compute_cache_key() const;
     // void preprocess();
 
 
@@ -600,6 +990,15 @@ namespace geoflow {
     virtual void on_connect_input(gfInputTerminal& ot){};
     virtual void on_connect_output(gfOutputTerminal& ot){};
     virtual void on_change_parameter(std::string name, Parameter& param){};
+    // return true if process() can be called once for every batch of elements on the vector inputs, while the upstream node is still 
+    // producing. process() must append to the vector outputs in that case, since they are not cleared between batches. See emit_batch()
+    virtual bool supports_streaming() const { return false; };
+    // return true if on_receive() and on_clear() touch GUI or OpenGL state. When a run happens on another thread
+    // than the one passed to NodeManager::set_main_thread(), these calls are handed to the main thread instead
+    virtual bool requires_main_thread() const { return false; };
+    // memory in kB that the next process() call needs, used to stay within NodeManager::memory_budget_kb. Override this to 
+    // declare an estimate, eg. from the size of the inputs. 0 means unknown, such nodes are not limited by the budget
+    virtual size_t estimate_memory_kb() const { return memory_estimate_kb; };
     virtual void before_gui(){};
     virtual std::string info() {return std::string();};
 
@@ -610,11 +1009,30 @@ namespace geoflow {
 
     protected:
     void set_name(std::string new_name);
+    // Hand the elements that were pushed to the vector outputs so far to the downstream nodes that support streaming, and clear those outputs.
+    // Call this from process() every so many features to keep the memory use bounded. Does nothing unless NodeManager::streaming is 
+    // enabled and all nodes connected to an output support streaming, the elements then simply stay in the outputs
+    void emit_batch();
+    // streaming state, only set during NodeManager::run_all_parallel()
+    Node* stream_producer_ = nullptr;
+    std::vector<Node*> stream_consumers_;
+    std::vector<gfSingleFeatureOutputTerminal*> stream_outputs_;
+    std::vector<std::shared_ptr<StreamChannel>> stream_channels_;
+    // memory reserved for the current process() call, see NodeManager::reserve_memory(). A node that schedules its own 
+    // work (eg. NestNode) may release it early and reserve memory per work item instead
+    size_t reserved_memory_kb_ = 0;
+    // binary dump of the data in all output terminals, used for the disk cache
+    void write_outputs(std::ostream& os);
+    void read_outputs(std::istream& is);
     const std::string type_name; // to be managed only by node manager because uniqueness constraint (among all nodes in the manager)
     NodeManager& manager;
     NodeRegisterHandle node_register;
 
     friend class NodeManager;
+    friend class gfInputTerminal;
+    friend class gfOutputTerminal;
+    friend class gfSingleFeatureInputTerminal;
+    friend class gfMultiFeatureInputTerminal;
   };
 
   class NodeRegister : public std::enable_shared_from_this<NodeRegister> {
@@ -668,6 +1086,30 @@ namespace geoflow {
     }
   };
 
+  // memory use of the output terminals during the last run_all(), see NodeManager::release_consumed_outputs
+  struct MemoryReport {
+    // largest estimated size of the output data that was produced in the run and not yet released
+    size_t peak_output_bytes = 0;
+    // output data that was released because all consumers had read it
+    size_t released_output_bytes = 0;
+    size_t released_terminals = 0;
+    // peak resident set size of the process
+    long peak_rss_kb = 0;
+    // number of times that work had to wait for memory_budget_kb
+    size_t deferred = 0;
+  };
+
+  // The nodes of a flowchart in topological order, ie. every node comes after all of its parents. The children of 
+  // nodes[i] are the nodes with the indices children[child_offsets[i]] up to children[child_offsets[i+1]-1].
+  struct ExecutionPlan {
+    std::vector<Node*> nodes;
+    std::vector<size_t> child_offsets;
+    std::vector<size_t> children;
+    // number of distinct parents of each node
+    std::vector<size_t> parent_count;
+    std::unordered_map<const Node*, size_t> index;
+  };
+
   class NodeManager {
     // manages a set of nodes that form one flowchart. Every node must linked to a NodeManager.
     private:
@@ -677,16 +1119,35 @@ namespace geoflow {
 
     public:
     std::unordered_map<std::string, std::shared_ptr<Parameter>> global_flowchart_params;
+    // the offset that is shared by all geometries in this flowchart, see Geometry::offset() and get_data_offset()
     std::optional<std::array<double,3>> data_offset;
+    // number of worker threads used by run_all(). 1 means nodes are processed one after another on the calling thread, 0 means use all hardware threads
+    size_t n_threads = 1;
+    // only rerun nodes whose parameters or input data changed since their last run, all other nodes keep their outputs
+    bool incremental = false;
+    // folder for the results of nodes that have use_disk_cache enabled, caching is disabled if empty
+    std::string cache_dir;
+    // record a trace event for every processed node, see dump_trace()
+    bool record_trace = false;
+    // let nodes that support streaming process the batches emitted by their upstream node while it is still running, see Node::emit_batch()
+    bool streaming = false;
+    // maximum number of batches that are buffered between a streaming producer and each of its consumers
+    size_t stream_buffer_size = 4;
+    // free the data of an output terminal in run_all() as soon as all connected nodes were processed. Data is kept for 
+    // outputs without connections, marked terminals and terminals with keep_data set, outputs that are connected to 
+    // a marked input or to a node that requires the main thread (eg. a viewer), and in incremental mode
+    bool release_consumed_outputs = false;
+    // limit in kB for the summed memory estimates of the nodes that run_all() processes at the same time and of the items 
+    // that a NestNode processes in parallel, see Node::estimate_memory_kb(). Work that does not fit waits until enough 
+    // memory is released, work with a smaller estimate can go first. 0 means no limit
+    size_t memory_budget_kb = 0;
     NodeManager(NodeRegisterMap&  node_registers)
       : registers_(node_registers) {};
     NodeManager(NodeManager&  other_node_manager)
       : registers_(other_node_manager.registers_) {
-        std::stringstream ss;
-        other_node_manager.json_serialise(ss);
         set_globals(other_node_manager);
-        json_unserialise(ss);
-        data_offset = *other_node_manager.data_offset;
+        clone_nodes(other_node_manager);
+        copy_settings(other_node_manager);
       };
     
     NodeRegisterMap& get_node_registers() const { return registers_; };
@@ -712,19 +1173,141 @@ namespace geoflow {
     std::vector<NodeHandle> json_unserialise(std::istream& json_sstream, bool strict=false);
     void json_serialise(std::ostream& json_sstream);
 
+    // copy the nodes of another flowchart into this one, including parameter values, masters, marked terminals and connections. 
+    // Masters are looked up by name in the globals of this flowchart.
+    std::vector<NodeHandle> clone_nodes(NodeManager& other_manager);
+
     void set_globals(const NodeManager& other_manager);
+    // like set_globals(), but this flowchart gets its own copy of each global so that its values can be changed without 
+    // affecting other_manager. Call this before clone_nodes() so that the cloned parameters use the copies as master
+    void copy_globals(const NodeManager& other_manager);
+    // copy data_offset and the run settings (n_threads, incremental, cache_dir etc.) of another flowchart
+    void copy_settings(const NodeManager& other_manager);
 
     std::string substitute_globals(const std::string& text) const;
+
+    // returns data_offset, it is set to p first if it has no value yet. Reader nodes pass the first point they read and 
+    // then store their coordinates relative to the returned offset, eg. with Geometry::set_offset() and Geometry::to_local()
+    arr3d get_data_offset(const arr3d& p);
+    // resolve data_offset through another flowchart that outlives this one, eg. the flowchart that contains a NestNode, 
+    // so that all copies of a nested flowchart store their geometries in the same local frame
+    void share_data_offset(NodeManager& other_manager);
+    // rebase the geometry on data_offset so that it can be combined with the other geometries in this flowchart. Sets 
+    // data_offset to the offset of the geometry if it has no value yet
+    void align_offset(Geometry& geometry);
     
+    // write the recorded trace events in the Chrome trace event format (open with chrome://tracing or https://ui.perfetto.dev)
+    void dump_trace(std::string filepath);
+    void clear_trace();
+    // print a table with the metrics of all nodes, sorted by total wall time
+    void print_metrics(std::ostream& os);
+    MemoryReport get_memory_report() const;
+    void print_memory_report(std::ostream& os);
+    // block until estimate_kb fits in memory_budget_kb next to the memory that is reserved already, and reserve it. An 
+    // estimate larger than the budget waits until nothing else is reserved. Returns the reserved amount, which must be 
+    // passed to release_memory() afterwards. Returns 0 right away if there is no budget or the estimate is 0
+    size_t reserve_memory(size_t estimate_kb);
+    void release_memory(size_t reserved_kb);
+    // reserve memory from the budget of another flowchart that outlives this one, eg. so that flowcharts that run 
+    // concurrently as copies of one flowchart stay within a single memory_budget_kb together
+    void share_memory_budget(NodeManager& other_manager);
+
+    // returns the execution plan of the current graph, it is only rebuilt after nodes or connections were added or removed
+    std::shared_ptr<const ExecutionPlan> get_execution_plan();
+    // called when nodes or connections are added or removed
+    void invalidate_execution_plan() { ++graph_version_; };
+
+    size_t get_worker_count() const;
     size_t run_all(bool notify_children=true);
+    // run all nodes downstream of the autorun root nodes as a dependency graph on a pool of get_worker_count() threads. 
+    // In incremental mode notify_children is ignored and unchanged nodes are skipped. 
+    // With streaming enabled, streaming consumers run on their own threads next to their producer
+    size_t run_all_parallel(bool notify_children=true);
     size_t run(Node &node, bool notify_children=true);
     size_t run(NodeHandle node, bool notify_children=true) {
       return run(*node, notify_children);
     };
+    // process only this node if it is ready. Its children are told about the new data, but are not run. Returns false if the node was not ready
+    bool run_single(Node& node);
+
+    // start run_all() or run() on a background thread. Returns false if a run is already in progress
+    bool run_all_async(bool notify_children=true);
+    bool run_async(NodeHandle node, bool notify_children=true);
+    bool is_running() const { return running_.load(); };
+    // block until the background run is finished
+    void wait();
+    // number of finished and scheduled nodes of the current background run
+    std::pair<size_t, size_t> get_progress() const { return {progress_done_.load(), progress_total_.load()}; };
+    // error message of the last background run that failed, empty if it succeeded
+    std::string get_run_error();
+
+    // the thread that owns the GUI, see Node::requires_main_thread()
+    void set_main_thread(std::thread::id id) { main_thread_id_ = id; };
+    // call fn now, or queue it for the main thread if n requires the main thread and we are on another thread
+    void call_on_main_thread(Node& n, std::function<void()> fn);
+    // run the calls that were handed to the main thread, the GUI does this once per frame. Returns the number of calls
+    size_t process_main_thread_calls();
+
+    ~NodeManager();
     
     protected:
-    std::queue<NodeHandle> node_queue;
-    void queue(NodeHandle n);
+    std::atomic<size_t> graph_version_{0};
+    std::mutex plan_mutex_;
+    std::shared_ptr<const ExecutionPlan> plan_;
+    size_t plan_version_ = 0;
+    // serialises the log output of concurrently processed nodes
+    std::mutex log_mutex_;
+    // guards data_offset in get_data_offset() and align_offset(), readers can run concurrently
+    std::mutex data_offset_mutex_;
+    // set by share_data_offset()
+    NodeManager* data_offset_source_ = nullptr;
+    std::thread run_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> progress_done_{0}, progress_total_{0};
+    std::mutex run_error_mutex_;
+    std::string run_error_;
+    std::thread::id main_thread_id_;
+    std::mutex main_thread_calls_mutex_;
+    std::queue<std::pair<std::weak_ptr<Node>, std::function<void()>>> main_thread_calls_;
+    template<typename F> bool start_background_run(F run_fn);
+    struct TraceEvent {
+      std::string name, category;
+      size_t thread;
+      double start_us, duration_us;
+      NodeMetrics metrics;
+    };
+    std::vector<TraceEvent> trace_events_;
+    std::unordered_map<std::thread::id, size_t> trace_threads_;
+    std::mutex trace_mutex_;
+    std::chrono::steady_clock::time_point trace_start_ = std::chrono::steady_clock::now();
+    // output terminals whose consumers are counted in the current run, see release_consumed_outputs
+    std::vector<gfOutputTerminal*> release_terminals_;
+    std::atomic<size_t> live_output_bytes_{0}, peak_output_bytes_{0}, released_output_bytes_{0}, released_terminals_{0};
+    // guard the memory reserved from memory_budget_kb
+    std::mutex memory_mutex_;
+    std::condition_variable memory_released_;
+    size_t reserved_memory_kb_ = 0;
+    // set by share_memory_budget()
+    NodeManager* memory_budget_source_ = nullptr;
+    std::atomic<size_t> deferred_{0};
+    // thread pool of run_all_parallel(), kept between runs so that repeated runs (eg. per item of a NestNode) do not 
+    // start new threads every time. Recreated when the number of workers changes
+    std::shared_ptr<tf::Executor> executor_;
+    tf::Executor& get_executor();
+
+    void process_node(Node& n);
+    // find the nodes that can be streamed to and group them with their producers, returns false if there are none
+    bool plan_streaming(const std::vector<Node*>& run_nodes);
+    // call produce() while the streaming consumers of n process the emitted batches on their own threads
+    void run_with_stream_consumers(Node& n, std::function<void()> produce, std::atomic<size_t>& run_count);
+    void consume_stream(Node& n, StreamChannel& channel, std::atomic<size_t>& run_count);
+    bool load_cached_outputs(Node& n);
+    void store_cached_outputs(Node& n);
+    // count the consumers of the outputs of run_nodes whose data may be released, and reset the memory report
+    void begin_output_release(const std::vector<Node*>& run_nodes);
+    // called after n was processed, releases the outputs connected to n that have no other pending consumers
+    void release_consumed_inputs(Node& n);
+    void end_output_release();
     
     friend class Node;
   };
@@ -152,6 +152,7 @@ CanvasState::CanvasState() noexcept
     colors[ColSelectBorder] = imgui_style.Colors[ImGuiCol_Border];
     colors[ColNodeWaitingBorder] = ImColor(1.0f, 1.0f, 0.0f, 1.0f);
     colors[ColNodeReadyBorder] = ImColor(0.0f, 0.0f, 1.0f, 1.0f);
+    colors[ColNodeProcessingBorder] = ImColor(1.0f, 0.5f, 0.0f, 1.0f);
     colors[ColNodeDoneBorder] = ImColor(0.0f, 1.0f, 0.0f, 1.0f);
 }
 
@@ -452,6 +453,8 @@ void EndNode()
         node_border_color = canvas->colors[ColNodeWaitingBorder];
     else if (gf_node->status_ == geoflow::GF_NODE_READY)
         node_border_color = canvas->colors[ColNodeReadyBorder];
+    else if (gf_node->status_ == geoflow::GF_NODE_PROCESSING)
+        node_border_color = canvas->colors[ColNodeProcessingBorder];
     else if (gf_node->status_ == geoflow::GF_NODE_DONE)
         node_border_color = canvas->colors[ColNodeDoneBorder];
     draw_list->AddRectFilled(node_rect.Min, node_rect.Max, node_color, style.FrameRounding);
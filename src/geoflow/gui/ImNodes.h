@@ -49,6 +49,7 @@ enum StyleColor
     ColSelectBorder,
     ColNodeWaitingBorder,
     ColNodeReadyBorder,
+    ColNodeProcessingBorder,
     ColNodeDoneBorder,
     ColMax
 };
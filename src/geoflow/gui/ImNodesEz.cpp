@@ -122,7 +122,12 @@ bool Slot(geoflow::gfTerminal* term, int kind)
         float circle_offset_y = title_size.y / 2.f - CIRCLE_RADIUS;
         circle_rect.Min.y += circle_offset_y;
         circle_rect.Max.y += circle_offset_y;
-        auto status_color = gCanvas->colors[term->has_data() ? ImNodes::ColNodeDoneBorder : ImNodes::ColNodeWaitingBorder];
+        // only published data, the node may still be processed on a background thread
+        bool has_data = term->get_side()==geoflow::GF_OUT ? ((geoflow::gfOutputTerminal*) term)->is_published() : ((geoflow::gfInputTerminal*) term)->is_published();
+        // the data (and the sub terminals of a multi feature terminal) can only be read once it is published or when no 
+        // run is in progress
+        bool can_read = has_data || !term->get_parent().get_manager().is_running();
+        auto status_color = gCanvas->colors[has_data ? ImNodes::ColNodeDoneBorder : ImNodes::ColNodeWaitingBorder];
         draw_lists->AddCircleFilled(circle_rect.GetCenter(), CIRCLE_RADIUS, color);
         draw_lists->AddCircle(circle_rect.GetCenter(), CIRCLE_RADIUS, status_color, 12, term->is_marked()?4.0f:2.0f);
 
@@ -144,14 +149,15 @@ bool Slot(geoflow::gfTerminal* term, int kind)
                 ImGui::Text("Input %s", it->is_optional() ? "(optional)" : "");
             } else {
                 auto* ot = (geoflow::gfOutputTerminal*) term;
-                ImGui::Text("Output (%lu connections)", ot->get_connections().size());
+                ImGui::Text("Output (%lu connections)", ot->connection_count());
+                ImGui::Text("Keep data: %s", ot->get_keep_data() ? "yes" : "no");
             }
             ImGui::Text("Is touched %s", term->is_touched() ? "yes" : "no");
-            ImGui::Text("Has data: %s", term->has_data() ? "yes" : "no");
+            ImGui::Text("Has data: %s", has_data ? "yes" : "no");
             ImGui::Text("Marked: %s", term->is_marked() ? "yes" : "no");
             if (term->get_family()==geoflow::GF_SINGLE_FEATURE ) {
                 ImGui::TextUnformatted("Family: Single Feature");
-                if(term->has_data()) {
+                if(has_data) {
                     if (term->get_side()==geoflow::GF_IN) {
                         auto* it = (geoflow::gfSingleFeatureInputTerminal*) term;
                         ImGui::SameLine(); ImGui::Text("(size: %lu)", it->size());
@@ -161,7 +167,9 @@ bool Slot(geoflow::gfTerminal* term, int kind)
                     }
                 }
             } else if (term->get_family()==geoflow::GF_MULTI_FEATURE ) {
-                if(term->get_side()==geoflow::GF_IN) {
+                if(!can_read) {
+                    ImGui::TextUnformatted("Family: Multi Feature");
+                } else if(term->get_side()==geoflow::GF_IN) {
                     ImGui::TextUnformatted("Family: Multi Feature");
                     auto* it = (geoflow::gfMultiFeatureInputTerminal*) term;
                     for (auto& subterm : it->sub_terminals()) {
@@ -51,15 +51,19 @@ class gfImNodes : public RenderObject {
 
   gfImNodes(geoflow::NodeManager& node_manager, poviApp& app, std::string flowchart_file)
     : node_manager_(node_manager), app_(app), flowchart_file_(flowchart_file) {
+      // flowcharts run on a background thread, painters receive their data on this thread
+      node_manager_.set_main_thread(std::this_thread::get_id());
       init_node_draw_list();
       canvas_.style.curve_thickness = 2.f;
     };
   ~gfImNodes() {
+    node_manager_.wait();
     node_draw_list_.clear();
     node_manager_.clear();
   }
 
   void menu() {
+    bool running = node_manager_.is_running();
 		{
 			if (ImGui::BeginMenu("File"))
 			{
@@ -79,7 +83,7 @@ class gfImNodes : public RenderObject {
               node_manager_.dump_json(result.value());
             }
           }
-          if (ImGui::MenuItem("Load from JSON", "Ctrl+O")) {
+          if (ImGui::MenuItem("Load from JSON", "Ctrl+O", false, !running)) {
             auto result = osdialog_file(OSDIALOG_OPEN, NULL, "JSON:json");
             if (result.has_value()) {
               node_manager_.clear();
@@ -99,16 +103,23 @@ class gfImNodes : public RenderObject {
 			}
 		}
     if (ImGui::BeginMenu("Flowchart")) {
-        if (ImGui::MenuItem("Run all root nodes")) {
-					node_manager_.run_all();
+        if (ImGui::MenuItem("Run all root nodes", nullptr, false, !running)) {
+					node_manager_.run_all_async();
 				}
-        // This sort of works, but very prone to crashes because most of geoflow is not threadsafe atm. Especially painters.
-        // if (ImGui::MenuItem("Run all threaded")) {
-        //   std::thread t_run(&geoflow::NodeManager::run_all, &node_manager_);
-        //   t_run.detach();
-        // }
+        // the run settings are read by the background thread of a run
+        if (running) {
+          ImGui::TextDisabled("Settings can not be changed while the flowchart is running");
+        } else {
+          int n_threads = node_manager_.n_threads;
+          if (ImGui::InputInt("Worker threads", &n_threads)) {
+            node_manager_.n_threads = std::max(n_threads, 0);
+          }
+          ImGui::Checkbox("Incremental runs", &node_manager_.incremental);
+          ImGui::Checkbox("Streaming", &node_manager_.streaming);
+          ImGui::InputText("Cache folder", &node_manager_.cache_dir);
+        }
 				ImGui::Separator();
-        if (ImGui::MenuItem("Clear flowchart")) {
+        if (ImGui::MenuItem("Clear flowchart", nullptr, false, !running)) {
 					node_draw_list_.clear();
 					node_manager_.clear();
 				}
@@ -117,7 +128,8 @@ class gfImNodes : public RenderObject {
 				}
       ImGui::EndMenu();
     }
-    if (ImGui::BeginMenu("Globals")) {
+    // globals are read by the background thread of a run
+    if (ImGui::BeginMenu("Globals", !running)) {
       // std::string to_remove;
       for (auto it=node_manager_.global_flowchart_params.begin(); it!=node_manager_.global_flowchart_params.end(); ) {
         draw_global_parameter(it->second.get());
@@ -166,9 +178,21 @@ class gfImNodes : public RenderObject {
 
     const ImGuiStyle& style = ImGui::GetStyle();
 
+    // hand the results of the background run to the painters. The graph can not be edited while it is running
+    node_manager_.process_main_thread_calls();
+    bool running = node_manager_.is_running();
 
     if (ImGui::Begin("Flowchart", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
     {
+        if (running) {
+          auto [done, total] = node_manager_.get_progress();
+          auto overlay = "Running " + std::to_string(done) + "/" + std::to_string(total) + " nodes";
+          ImGui::ProgressBar(total ? float(done)/total : 0.f, ImVec2(-1,0), overlay.c_str());
+        } else {
+          auto run_error = node_manager_.get_run_error();
+          if (!run_error.empty())
+            ImGui::TextColored(ImVec4(1,0,0,1), "Run failed: %s", run_error.c_str());
+        }
         // We probably need to keep some state, like positions of nodes/slots for rendering connections.
         ImNodes::BeginCanvas(&canvas_);
         bool one_node_hovered = false;
@@ -195,7 +219,7 @@ class gfImNodes : public RenderObject {
                 const char* source_term_title=nullptr;
                 const char* target_term_title=nullptr;
                 if (ImNodes::GetNewConnection(&target_node_, &target_term_title,
-                    &source_node_, &source_term_title))
+                    &source_node_, &source_term_title) && !running)
                 {
                     auto source_node = (geoflow::Node*)(source_node_);
                     auto target_node = (geoflow::Node*)(target_node_);
@@ -203,7 +227,7 @@ class gfImNodes : public RenderObject {
                     auto& target_term = target_node->input_terminals[std::string(target_term_title)];
                     // std::cerr << "connect " << source_node->get_name() << " [" << source_term_title << ", " << &source_term << "] to " << target_node->get_name() << " [" << target_term_title << ", " << &target_term << "]\n";
                     source_term->connect(*target_term);
-                    node_manager_.run(*target_node);
+                    node_manager_.run_async(target_node->get_handle());
                 }
 
                 // Render output connections of this node
@@ -225,6 +249,7 @@ class gfImNodes : public RenderObject {
                         to_delete.push_back(input_term);
                       }
                     }
+                    if (running) to_delete.clear();
                     for (auto& input_term : to_delete) {
                       output_term->disconnect(*input_term);
                     }
@@ -249,23 +274,37 @@ class gfImNodes : public RenderObject {
               // ImGui::Text("%s", node->debug_info().c_str());
               // ImGui::Text("position: %.2f, %.2f", element_.node_slot0_->position_.x, element_.node_slot0_->position_.y);
               // node->gui();
-              ImGui::InputText("##name", &name_buffer);
-              ImGui::SameLine();
-              if(ImGui::Button("Rename")) {
-                if(!node_manager_.name_node(node, name_buffer))
-                  name_buffer = node->get_name();
+              if (running) {
+                ImGui::Text("%s", node->get_name().c_str());
+              } else {
+                ImGui::InputText("##name", &name_buffer);
+                ImGui::SameLine();
+                if(ImGui::Button("Rename")) {
+                  if(!node_manager_.name_node(node, name_buffer))
+                    name_buffer = node->get_name();
+                }
+                ImGui::Checkbox("Autorun", &(node->autorun));
+                ImGui::Checkbox("Cache results on disk", &(node->use_disk_cache));
               }
-              ImGui::Checkbox("Autorun", &(node->autorun));
-              if (ImGui::MenuItem("Run")) {
-                node_manager_.run(*node);
+              if (ImGui::MenuItem("Run", nullptr, false, !running)) {
+                node_manager_.run_async(node);
+              }
+              {
+                auto& metrics = node->get_metrics();
+                if (metrics.calls)
+                  ImGui::Text("Last run: %.1f ms wall, %.1f ms cpu (%zu runs)", metrics.wall_time_ms, metrics.cpu_time_ms, metrics.calls);
               }
               ImGui::Separator();
               
-              node->gui();
-              if (node->get_register().get_name() != "Visualisation") {
-                if (ImGui::CollapsingHeader("Parameters", ImGuiTreeNodeFlags_DefaultOpen)) {
-                  geoflow::draw_parameters(node);
-                  ImGui::Text("%s", node->info().c_str());
+              if (running) {
+                ImGui::Text("Flowchart is running...");
+              } else {
+                node->gui();
+                if (node->get_register().get_name() != "Visualisation") {
+                  if (ImGui::CollapsingHeader("Parameters", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    geoflow::draw_parameters(node);
+                    ImGui::Text("%s", node->info().c_str());
+                  }
                 }
               }
               // if (ImGui::MenuItem("Destroy")) {					
@@ -278,7 +317,7 @@ class gfImNodes : public RenderObject {
             }
             ImGui::PopID();
 
-            if (selected && ImGui::IsKeyPressedMap(ImGuiKey_Delete)) {
+            if (selected && !running && ImGui::IsKeyPressedMap(ImGuiKey_Delete)) {
               node_manager_.remove_node(node);
               node_draw_list_.erase(node_it);
             } else
@@ -288,6 +327,7 @@ class gfImNodes : public RenderObject {
         const ImGuiIO& io = ImGui::GetIO();
         if (
           !one_node_hovered && 
+          !running &&
           ImGui::IsMouseReleased(1) && 
           ImGui::IsWindowHovered() && 
           !ImGui::IsMouseDragging(1)
@@ -226,6 +226,8 @@ namespace geoflow::nodes::gui {
       a.add_painter(painter, get_name_ptr());
       pv_app = a.get_ptr();
     }
+    // painters upload their inputs to OpenGL buffers in on_receive()
+    bool requires_main_thread() const override { return true; }
   };
 
   class PainterNode:public BasePainterNode {
@@ -235,10 +237,14 @@ namespace geoflow::nodes::gui {
     void init() {
       add_input("geometries", {
         typeid(PointCollection), 
+        typeid(PointCloud), 
         typeid(TriangleCollection),
+        typeid(IndexedMesh),
         typeid(SegmentCollection),
         typeid(LineStringCollection),
         typeid(LinearRingCollection),
+        typeid(PackedLineStringCollection),
+        typeid(PackedLinearRingCollection),
         typeid(LinearRing)
       });
       add_input("normals", typeid(vec3f));
@@ -268,10 +274,18 @@ namespace geoflow::nodes::gui {
             auto& gc = input("geometries").get<PointCollection&>();
             painter->set_geometry(gc);
             painter->set_drawmode(GL_POINTS);
+          } else if (t.is_connected_type(typeid(PointCloud))) {
+            auto& gc = input("geometries").get<PointCloud&>();
+            painter->set_geometry(gc);
+            painter->set_drawmode(GL_POINTS);
           } else if (t.is_connected_type(typeid(TriangleCollection))) {
             auto& gc = input("geometries").get<TriangleCollection&>();
             painter->set_geometry(gc);
             painter->set_drawmode(GL_TRIANGLES);
+          } else if (t.is_connected_type(typeid(IndexedMesh))) {
+            auto& gc = input("geometries").get<IndexedMesh&>();
+            painter->set_geometry(gc);
+            painter->set_drawmode(GL_TRIANGLES);
           } else if(t.is_connected_type(typeid(LineStringCollection))) {
             auto& gc = input("geometries").get<LineStringCollection&>();
             painter->set_geometry(gc);
@@ -284,6 +298,14 @@ namespace geoflow::nodes::gui {
             auto& gc = input("geometries").get<LinearRingCollection&>();
             painter->set_geometry(gc);
             painter->set_drawmode(GL_LINE_LOOP);
+          } else if (t.is_connected_type(typeid(PackedLineStringCollection))) {
+            auto& gc = input("geometries").get<PackedLineStringCollection&>();
+            painter->set_geometry(gc);
+            painter->set_drawmode(GL_LINE_STRIP);
+          } else if (t.is_connected_type(typeid(PackedLinearRingCollection))) {
+            auto& gc = input("geometries").get<PackedLinearRingCollection&>();
+            painter->set_geometry(gc);
+            painter->set_drawmode(GL_LINE_LOOP);
           } else if (t.is_connected_type(typeid(LinearRing))) {
             auto& gc = input("geometries").get<LinearRing&>();
             LinearRingCollection lrc;
@@ -0,0 +1,250 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "kernels.hpp"
+
+#if defined(__AVX2__)
+  #define GF_KERNELS_AVX2
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define GF_KERNELS_SSE2
+  #include <emmintrin.h>
+#endif
+
+namespace geoflow::kernels
+{
+
+const char* instruction_set() {
+#if defined(GF_KERNELS_AVX2)
+  return "AVX2";
+#elif defined(GF_KERNELS_SSE2)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+void minmax(const float* v, size_t n, float& vmin, float& vmax) {
+  if (n==0) return;
+  float lo = v[0], hi = v[0];
+  size_t i = 0;
+#if defined(GF_KERNELS_AVX2)
+  if (n >= 8) {
+    __m256 vlo = _mm256_loadu_ps(v), vhi = vlo;
+    for (i = 8; i + 8 <= n; i += 8) {
+      __m256 x = _mm256_loadu_ps(v + i);
+      vlo = _mm256_min_ps(vlo, x);
+      vhi = _mm256_max_ps(vhi, x);
+    }
+    alignas(32) float l[8], h[8];
+    _mm256_store_ps(l, vlo);
+    _mm256_store_ps(h, vhi);
+    for (size_t j=0; j<8; ++j) {
+      lo = std::min(lo, l[j]);
+      hi = std::max(hi, h[j]);
+    }
+  }
+#elif defined(GF_KERNELS_SSE2)
+  if (n >= 4) {
+    __m128 vlo = _mm_loadu_ps(v), vhi = vlo;
+    for (i = 4; i + 4 <= n; i += 4) {
+      __m128 x = _mm_loadu_ps(v + i);
+      vlo = _mm_min_ps(vlo, x);
+      vhi = _mm_max_ps(vhi, x);
+    }
+    alignas(16) float l[4], h[4];
+    _mm_store_ps(l, vlo);
+    _mm_store_ps(h, vhi);
+    for (size_t j=0; j<4; ++j) {
+      lo = std::min(lo, l[j]);
+      hi = std::max(hi, h[j]);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    lo = std::min(lo, v[i]);
+    hi = std::max(hi, v[i]);
+  }
+  vmin = lo;
+  vmax = hi;
+}
+
+// minmax_xyz for a single thread. The SIMD loops load W points at a time as 3 vectors of W floats, in which lane j of
+// vector k holds component (W*k + j) % 3
+static void minmax_xyz_block(const float* xyz, size_t n, float vmin[3], float vmax[3]) {
+  float lo[3] = {xyz[0], xyz[1], xyz[2]}, hi[3] = {xyz[0], xyz[1], xyz[2]};
+  size_t i = 0;
+#if defined(GF_KERNELS_AVX2) || defined(GF_KERNELS_SSE2)
+  #if defined(GF_KERNELS_AVX2)
+  constexpr size_t W = 8;
+  typedef __m256 vec;
+  auto load = [](const float* p) { return _mm256_loadu_ps(p); };
+  auto vmin_ = [](vec a, vec b) { return _mm256_min_ps(a, b); };
+  auto vmax_ = [](vec a, vec b) { return _mm256_max_ps(a, b); };
+  auto store = [](float* p, vec a) { _mm256_storeu_ps(p, a); };
+  #else
+  constexpr size_t W = 4;
+  typedef __m128 vec;
+  auto load = [](const float* p) { return _mm_loadu_ps(p); };
+  auto vmin_ = [](vec a, vec b) { return _mm_min_ps(a, b); };
+  auto vmax_ = [](vec a, vec b) { return _mm_max_ps(a, b); };
+  auto store = [](float* p, vec a) { _mm_storeu_ps(p, a); };
+  #endif
+  if (n >= W) {
+    vec lo_v[3], hi_v[3];
+    for (size_t k=0; k<3; ++k)
+      lo_v[k] = hi_v[k] = load(xyz + W*k);
+    for (i = W; i + W <= n; i += W) {
+      const float* p = xyz + 3*i;
+      for (size_t k=0; k<3; ++k) {
+        vec x = load(p + W*k);
+        lo_v[k] = vmin_(lo_v[k], x);
+        hi_v[k] = vmax_(hi_v[k], x);
+      }
+    }
+    float l[W], h[W];
+    for (size_t k=0; k<3; ++k) {
+      store(l, lo_v[k]);
+      store(h, hi_v[k]);
+      for (size_t j=0; j<W; ++j) {
+        size_t c = (W*k + j) % 3;
+        lo[c] = std::min(lo[c], l[j]);
+        hi[c] = std::max(hi[c], h[j]);
+      }
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    for (size_t c=0; c<3; ++c) {
+      lo[c] = std::min(lo[c], xyz[3*i+c]);
+      hi[c] = std::max(hi[c], xyz[3*i+c]);
+    }
+  }
+  for (size_t c=0; c<3; ++c) {
+    vmin[c] = lo[c];
+    vmax[c] = hi[c];
+  }
+}
+
+void minmax_xyz(const float* xyz, size_t n, float vmin[3], float vmax[3]) {
+  if (n==0) return;
+  // below this number of points the cost of starting threads outweighs the gain
+  const size_t min_points_per_thread = 1 << 20;
+  size_t n_threads = std::min<size_t>(std::thread::hardware_concurrency(), n / min_points_per_thread);
+  if (n_threads <= 1) {
+    minmax_xyz_block(xyz, n, vmin, vmax);
+    return;
+  }
+  std::vector<std::array<float, 6>> results(n_threads);
+  std::vector<std::thread> threads;
+  size_t chunk = n / n_threads;
+  for (size_t t=0; t<n_threads; ++t) {
+    size_t begin = t * chunk;
+    size_t count = t+1 == n_threads ? n - begin : chunk;
+    threads.emplace_back([&results, xyz, begin, count, t]() {
+      minmax_xyz_block(xyz + 3*begin, count, results[t].data(), results[t].data() + 3);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (size_t c=0; c<3; ++c) {
+    vmin[c] = results[0][c];
+    vmax[c] = results[0][3+c];
+    for (auto& r : results) {
+      vmin[c] = std::min(vmin[c], r[c]);
+      vmax[c] = std::max(vmax[c], r[3+c]);
+    }
+  }
+}
+
+void add_scalar(float* v, size_t n, float s) {
+  size_t i = 0;
+#if defined(GF_KERNELS_AVX2)
+  __m256 vs = _mm256_set1_ps(s);
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(v + i, _mm256_add_ps(_mm256_loadu_ps(v + i), vs));
+#elif defined(GF_KERNELS_SSE2)
+  __m128 vs = _mm_set1_ps(s);
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(v + i, _mm_add_ps(_mm_loadu_ps(v + i), vs));
+#endif
+  for (; i < n; ++i)
+    v[i] += s;
+}
+
+void mask_range(const float* v, size_t n, float vmin, float vmax, unsigned char* mask) {
+  size_t i = 0;
+#if defined(GF_KERNELS_AVX2)
+  __m256 vlo = _mm256_set1_ps(vmin), vhi = _mm256_set1_ps(vmax);
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(v + i);
+    int inside = _mm256_movemask_ps(_mm256_and_ps(
+      _mm256_cmp_ps(x, vlo, _CMP_GE_OQ),
+      _mm256_cmp_ps(x, vhi, _CMP_LE_OQ)
+    ));
+    if (inside == 0xff) continue;
+    for (size_t j=0; j<8; ++j)
+      if (!(inside & (1 << j))) mask[i+j] = 0;
+  }
+#elif defined(GF_KERNELS_SSE2)
+  __m128 vlo = _mm_set1_ps(vmin), vhi = _mm_set1_ps(vmax);
+  for (; i + 4 <= n; i += 4) {
+    __m128 x = _mm_loadu_ps(v + i);
+    int inside = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(x, vlo), _mm_cmple_ps(x, vhi)));
+    if (inside == 0xf) continue;
+    for (size_t j=0; j<4; ++j)
+      if (!(inside & (1 << j))) mask[i+j] = 0;
+  }
+#endif
+  for (; i < n; ++i)
+    if (!(v[i] >= vmin && v[i] <= vmax)) mask[i] = 0;
+}
+
+// the following loops are simple enough for the compiler to vectorise them
+void add_double(float* v, size_t n, double s) {
+  for (size_t i = 0; i < n; ++i)
+    v[i] = float(double(v[i]) + s);
+}
+
+void translate_xyz(float* xyz, size_t n, const double d[3]) {
+  for (size_t i = 0; i < n; ++i) {
+    xyz[3*i]   = float(double(xyz[3*i])   + d[0]);
+    xyz[3*i+1] = float(double(xyz[3*i+1]) + d[1]);
+    xyz[3*i+2] = float(double(xyz[3*i+2]) + d[2]);
+  }
+}
+
+void to_local(const double* src, size_t n, const double offset[3], float* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[3*i]   = float(src[3*i]   - offset[0]);
+    dst[3*i+1] = float(src[3*i+1] - offset[1]);
+    dst[3*i+2] = float(src[3*i+2] - offset[2]);
+  }
+}
+
+void to_global(const float* src, size_t n, const double offset[3], double* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[3*i]   = double(src[3*i])   + offset[0];
+    dst[3*i+1] = double(src[3*i+1]) + offset[1];
+    dst[3*i+2] = double(src[3*i+2]) + offset[2];
+  }
+}
+
+} // namespace geoflow::kernels
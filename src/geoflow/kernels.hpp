@@ -0,0 +1,52 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+// Kernels that process contiguous float arrays. Depending on the instruction sets that are enabled at compile
+// time they use AVX2 (see the GF_USE_AVX2 cmake option), SSE2 or plain scalar code.
+namespace geoflow::kernels
+{
+
+// name of the instruction set the kernels were compiled for, ie. "AVX2", "SSE2" or "scalar"
+const char* instruction_set();
+
+// computes the minimum and maximum of v[0..n). Leaves vmin and vmax untouched if n==0
+void minmax(const float* v, size_t n, float& vmin, float& vmax);
+
+// computes the per component minimum and maximum of the n x,y,z triplets in xyz. Leaves vmin and vmax untouched if
+// n==0. Large inputs are split over multiple threads
+void minmax_xyz(const float* xyz, size_t n, float vmin[3], float vmax[3]);
+
+// adds s to every element of v[0..n)
+void add_scalar(float* v, size_t n, float s);
+
+// clears mask[i] for every i where v[i] is outside of [vmin, vmax], other elements of the mask are left untouched
+void mask_range(const float* v, size_t n, float vmin, float vmax, unsigned char* mask);
+
+// adds s to every element of v[0..n), the sum is computed in double precision
+void add_double(float* v, size_t n, double s);
+
+// adds d to each of the n x,y,z triplets in xyz, the sum is computed in double precision
+void translate_xyz(float* xyz, size_t n, const double d[3]);
+
+// converts n absolute x,y,z triplets to float coordinates relative to offset, and back
+void to_local(const double* src, size_t n, const double offset[3], float* dst);
+void to_global(const float* src, size_t n, const double offset[3], double* dst);
+
+} // namespace geoflow::kernels
@@ -44,9 +44,12 @@ namespace geoflow {
     else
       master_parameter_ = master_parameter;
   };
+  void Parameter::copy_value_from(const Parameter& other_parameter) {
+    from_json(other_parameter.as_json());
+  };
   void Parameter::copy_value_from_master() {
-    if(!master_parameter_.expired()) {
-      from_json(master_parameter_.lock()->as_json());
+    if(auto master = master_parameter_.lock()) {
+      copy_value_from(*master);
     }
   };
   bool Parameter::has_master() const {
@@ -67,9 +70,21 @@ namespace geoflow {
   template <typename T> void ParameterByReference<T>::from_json(const json& json_object) {
     value_ = json_object.get<T>();
   };
+  template <typename T> void ParameterByReference<T>::copy_value_from(const Parameter& other_parameter) {
+    if (auto other = dynamic_cast<const ParameterByReference<T>*>(&other_parameter)) {
+      value_ = other->get();
+    } else if (auto other = dynamic_cast<const ParameterByValue<T>*>(&other_parameter)) {
+      value_ = other->get();
+    } else {
+      Parameter::copy_value_from(other_parameter);
+    }
+  };
   template <typename T> T& ParameterByReference<T>::get() {
     return value_;
   }
+  template <typename T> const T& ParameterByReference<T>::get() const {
+    return value_;
+  }
   template <typename T> void ParameterByReference<T>::set(T val) {
     value_ = val;
   }
@@ -82,9 +97,21 @@ namespace geoflow {
   template <typename T> void ParameterByValue<T>::from_json(const json& json_object) {
     value_ = json_object.get<T>();
   };
+  template <typename T> void ParameterByValue<T>::copy_value_from(const Parameter& other_parameter) {
+    if (auto other = dynamic_cast<const ParameterByValue<T>*>(&other_parameter)) {
+      value_ = other->get();
+    } else if (auto other = dynamic_cast<const ParameterByReference<T>*>(&other_parameter)) {
+      value_ = other->get();
+    } else {
+      Parameter::copy_value_from(other_parameter);
+    }
+  };
   template <typename T> T& ParameterByValue<T>::get() {
     return value_;
   }
+  template <typename T> const T& ParameterByValue<T>::get() const {
+    return value_;
+  }
   template <typename T> void ParameterByValue<T>::set(T val) {
     value_ = val;
   }
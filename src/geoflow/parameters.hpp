@@ -51,6 +51,8 @@ namespace geoflow {
     const std::string& get_help() const;
     virtual json as_json() const = 0;
     virtual void from_json(const json& json_object) = 0;
+    // copy the value of another parameter of the same type. Falls back to a json round trip if the value can not be copied directly
+    virtual void copy_value_from(const Parameter& other_parameter);
     // virtual void to_string(std::string& str) const = 0;
     // virtual void from_string(const std::string& str) = 0;
     bool is_type(std::type_index type);
@@ -72,7 +74,9 @@ namespace geoflow {
 
     virtual json as_json() const override;
     virtual void from_json(const json& json_object) override;
+    virtual void copy_value_from(const Parameter& other_parameter) override;
     T& get();
+    const T& get() const;
     void set(T val);
   };
   template<typename T> class ParameterByValue : public Parameter {
@@ -84,7 +88,9 @@ namespace geoflow {
 
     virtual json as_json() const override;
     virtual void from_json(const json& json_object) override;
+    virtual void copy_value_from(const Parameter& other_parameter) override;
     T& get();
+    const T& get() const;
     void set(T val);
   };
 
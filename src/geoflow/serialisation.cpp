@@ -0,0 +1,351 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdexcept>
+
+#include "serialisation.hpp"
+
+namespace geoflow
+{
+
+void write_binary(std::ostream& os, const Box& value) {
+  write_binary(os, value.isEmpty());
+  write_binary(os, value.min());
+  write_binary(os, value.max());
+}
+void read_binary(std::istream& is, Box& value) {
+  bool is_empty;
+  arr3f pmin, pmax;
+  read_binary(is, is_empty);
+  read_binary(is, pmin);
+  read_binary(is, pmax);
+  if (is_empty)
+    value.clear();
+  else
+    value.set(pmin, pmax);
+}
+
+// the double precision offset of the geometry types
+static void write_offset(std::ostream& os, const Geometry& value) {
+  write_binary(os, value.offset());
+}
+static void read_offset(std::istream& is, Geometry& value) {
+  arr3d offset;
+  read_binary(is, offset);
+  value.set_offset(offset);
+}
+
+// the columns are written as typed arrays, strings as their dictionary and codes
+void write_binary(std::ostream& os, const AttributeTable& value) {
+  write_binary(os, uint64_t(value.column_count()));
+  for (auto& name : value.column_names()) {
+    auto& column = value.column(name);
+    size_t n = column.size();
+    write_binary(os, name);
+    write_binary(os, int(column.type()));
+    std::vector<uint8_t> nulls(n);
+    for (size_t i=0; i<n; ++i) nulls[i] = column.is_null(i);
+    write_binary(os, nulls);
+    switch (column.type()) {
+      case AttributeTypeBool: write_binary(os, std::vector<uint8_t>(column.bools(), column.bools()+n)); break;
+      case AttributeTypeInt: write_binary(os, vec1i(column.ints(), column.ints()+n)); break;
+      case AttributeTypeFloat: write_binary(os, vec1f(column.floats(), column.floats()+n)); break;
+      case AttributeTypeString:
+        write_binary(os, column.dictionary());
+        write_binary(os, std::vector<uint32_t>(column.codes(), column.codes()+n));
+        break;
+    }
+  }
+}
+void read_binary(std::istream& is, AttributeTable& value) {
+  value = AttributeTable();
+  uint64_t n_columns;
+  read_binary(is, n_columns);
+  for (uint64_t c=0; c<n_columns && is; ++c) {
+    std::string name;
+    int type;
+    std::vector<uint8_t> nulls;
+    read_binary(is, name);
+    read_binary(is, type);
+    read_binary(is, nulls);
+    AttributeColumn column{AttributeType(type)};
+    auto read_values = [&](auto values, auto to_value) {
+      read_binary(is, values);
+      for (size_t i=0; i<nulls.size() && i<values.size(); ++i) {
+        if (nulls[i]) column.push_null();
+        else column.push_back(to_value(values[i]));
+      }
+    };
+    switch (AttributeType(type)) {
+      case AttributeTypeBool: read_values(std::vector<uint8_t>(), [](uint8_t v) { return attribute_value(bool(v)); }); break;
+      case AttributeTypeInt: read_values(vec1i(), [](int v) { return attribute_value(v); }); break;
+      case AttributeTypeFloat: read_values(vec1f(), [](float v) { return attribute_value(v); }); break;
+      case AttributeTypeString: {
+        vec1s dictionary;
+        read_binary(is, dictionary);
+        read_values(std::vector<uint32_t>(), [&dictionary](uint32_t v) { return attribute_value(dictionary.at(v)); });
+        break;
+      }
+    }
+    value.add_column(name, column);
+  }
+}
+
+void write_binary(std::ostream& os, const LinearRing& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const vec3f&>(value));
+  write_binary(os, value.interior_rings());
+}
+void read_binary(std::istream& is, LinearRing& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<vec3f&>(value));
+  read_binary(is, value.interior_rings());
+}
+
+void write_binary(std::ostream& os, const Segment& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const std::array<arr3f, 2>&>(value));
+}
+void read_binary(std::istream& is, Segment& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<std::array<arr3f, 2>&>(value));
+}
+
+void write_binary(std::ostream& os, const LineString& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const vec3f&>(value));
+}
+void read_binary(std::istream& is, LineString& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<vec3f&>(value));
+}
+
+void write_binary(std::ostream& os, const TriangleCollection& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const std::vector<Triangle>&>(value));
+}
+void read_binary(std::istream& is, TriangleCollection& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<std::vector<Triangle>&>(value));
+}
+
+void write_binary(std::ostream& os, const MultiTriangleCollection& value) {
+  write_binary(os, value.get_tricollections());
+  write_binary(os, value.get_attributes());
+  write_binary(os, value.building_part_ids_);
+}
+void read_binary(std::istream& is, MultiTriangleCollection& value) {
+  read_binary(is, value.get_tricollections());
+  read_binary(is, value.get_attributes());
+  read_binary(is, value.building_part_ids_);
+}
+
+void write_binary(std::ostream& os, const SegmentCollection& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const std::vector<std::array<arr3f, 2>>&>(value));
+}
+void read_binary(std::istream& is, SegmentCollection& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<std::vector<std::array<arr3f, 2>>&>(value));
+}
+
+void write_binary(std::ostream& os, const PointCollection& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const vec3f&>(value));
+}
+void read_binary(std::istream& is, PointCollection& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<vec3f&>(value));
+}
+
+void write_binary(std::ostream& os, const PointCloud& value) {
+  write_offset(os, value);
+  write_binary(os, value.x());
+  write_binary(os, value.y());
+  write_binary(os, value.z());
+  write_binary(os, value.attributes());
+}
+void read_binary(std::istream& is, PointCloud& value) {
+  read_offset(is, value);
+  read_binary(is, value.x());
+  read_binary(is, value.y());
+  read_binary(is, value.z());
+  read_binary(is, value.attributes());
+}
+
+void write_binary(std::ostream& os, const LineStringCollection& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const std::vector<vec3f>&>(value));
+}
+void read_binary(std::istream& is, LineStringCollection& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<std::vector<vec3f>&>(value));
+}
+
+void write_binary(std::ostream& os, const LinearRingCollection& value) {
+  write_offset(os, value);
+  write_binary(os, static_cast<const std::vector<vec3f>&>(value));
+}
+void read_binary(std::istream& is, LinearRingCollection& value) {
+  read_offset(is, value);
+  read_binary(is, static_cast<std::vector<vec3f>&>(value));
+}
+
+void write_binary(std::ostream& os, const PackedRingCollection& value) {
+  write_offset(os, value);
+  write_binary(os, value.vertices());
+  write_binary(os, value.offsets());
+}
+void read_binary(std::istream& is, PackedRingCollection& value) {
+  read_offset(is, value);
+  read_binary(is, value.vertices());
+  read_binary(is, value.offsets());
+}
+
+void write_binary(std::ostream& os, const PackedLineStringCollection& value) {
+  write_binary(os, static_cast<const PackedRingCollection&>(value));
+}
+void read_binary(std::istream& is, PackedLineStringCollection& value) {
+  read_binary(is, static_cast<PackedRingCollection&>(value));
+}
+
+void write_binary(std::ostream& os, const PackedLinearRingCollection& value) {
+  write_binary(os, static_cast<const PackedRingCollection&>(value));
+}
+void read_binary(std::istream& is, PackedLinearRingCollection& value) {
+  read_binary(is, static_cast<PackedRingCollection&>(value));
+}
+
+void write_binary(std::ostream& os, const Mesh& value) {
+  write_binary(os, value.get_polygons());
+  write_binary(os, value.get_labels());
+}
+void read_binary(std::istream& is, Mesh& value) {
+  read_binary(is, value.get_polygons());
+  read_binary(is, value.get_labels());
+}
+
+void write_binary(std::ostream& os, const IndexedMesh& value) {
+  write_offset(os, value);
+  write_binary(os, value.vertices());
+  write_binary(os, value.indices());
+  write_binary(os, value.ring_offsets());
+  write_binary(os, value.polygon_offsets());
+  write_binary(os, value.labels());
+}
+void read_binary(std::istream& is, IndexedMesh& value) {
+  read_offset(is, value);
+  read_binary(is, value.vertices());
+  read_binary(is, value.indices());
+  read_binary(is, value.ring_offsets());
+  read_binary(is, value.polygon_offsets());
+  read_binary(is, value.labels());
+}
+
+void write_binary(std::ostream& os, const DateTime& value) {
+  write_binary(os, value.date.year);
+  write_binary(os, value.date.month);
+  write_binary(os, value.date.day);
+  write_binary(os, value.time.hour);
+  write_binary(os, value.time.minute);
+  write_binary(os, value.time.second);
+  write_binary(os, value.time.timeZone);
+}
+void read_binary(std::istream& is, DateTime& value) {
+  read_binary(is, value.date.year);
+  read_binary(is, value.date.month);
+  read_binary(is, value.date.day);
+  read_binary(is, value.time.hour);
+  read_binary(is, value.time.minute);
+  read_binary(is, value.time.second);
+  read_binary(is, value.time.timeZone);
+}
+
+SerialiserRegistry::SerialiserRegistry() {
+  register_type<bool>("bool");
+  register_type<int>("int");
+  register_type<float>("float");
+  register_type<double>("double");
+  register_type<size_t>("size_t");
+  register_type<std::string>("string");
+  register_type<arr2f>("arr2f");
+  register_type<arr3f>("arr3f");
+  register_type<vec1b>("vec1b");
+  register_type<vec1i>("vec1i");
+  register_type<vec1f>("vec1f");
+  register_type<vec1ui>("vec1ui");
+  register_type<vec1s>("vec1s");
+  register_type<vec2f>("vec2f");
+  register_type<vec3f>("vec3f");
+  register_type<attribute_value>("attribute_value");
+  register_type<AttributeMap>("AttributeMap");
+  register_type<AttributeTable>("AttributeTable");
+  register_type<Box>("Box");
+  register_type<LinearRing>("LinearRing");
+  register_type<Segment>("Segment");
+  register_type<LineString>("LineString");
+  register_type<TriangleCollection>("TriangleCollection");
+  register_type<MultiTriangleCollection>("MultiTriangleCollection");
+  register_type<SegmentCollection>("SegmentCollection");
+  register_type<PointCollection>("PointCollection");
+  register_type<PointCloud>("PointCloud");
+  register_type<LineStringCollection>("LineStringCollection");
+  register_type<LinearRingCollection>("LinearRingCollection");
+  register_type<PackedLineStringCollection>("PackedLineStringCollection");
+  register_type<PackedLinearRingCollection>("PackedLinearRingCollection");
+  register_type<Mesh>("Mesh");
+  register_type<IndexedMesh>("IndexedMesh");
+  register_type<DateTime>("DateTime");
+}
+SerialiserRegistry& SerialiserRegistry::get() {
+  static SerialiserRegistry registry;
+  return registry;
+}
+bool SerialiserRegistry::can_serialise(std::type_index type) const {
+  return serialisers_.count(type) > 0;
+}
+const std::string& SerialiserRegistry::get_name(std::type_index type) const {
+  auto it = serialisers_.find(type);
+  if (it == serialisers_.end())
+    throw std::runtime_error(std::string("No serialiser registered for type ") + type.name());
+  return it->second.name;
+}
+std::type_index SerialiserRegistry::get_type(const std::string& name) const {
+  auto it = types_.find(name);
+  if (it == types_.end())
+    throw std::runtime_error("No serialiser registered with name " + name);
+  return it->second;
+}
+void SerialiserRegistry::write(std::ostream& os, const std::any& value) const {
+  if (!value.has_value()) {
+    write_binary(os, std::string());
+    return;
+  }
+  auto it = serialisers_.find(value.type());
+  if (it == serialisers_.end())
+    throw std::runtime_error(std::string("No serialiser registered for type ") + value.type().name());
+  write_binary(os, it->second.name);
+  it->second.write(os, value);
+}
+std::any SerialiserRegistry::read(std::istream& is) const {
+  std::string name;
+  read_binary(is, name);
+  if (name.empty() || !is)
+    return std::any();
+  return serialisers_.at(get_type(name)).read(is);
+}
+
+}
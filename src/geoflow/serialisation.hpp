@@ -0,0 +1,224 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <variant>
+#include <unordered_map>
+#include <functional>
+#include <type_traits>
+#include <any>
+#include <typeindex>
+
+#include "common.hpp"
+
+namespace geoflow {
+
+  // Binary serialisation of terminal data, used by the on-disk node result cache.
+  // The format is native endian and is only meant to be read back on the same platform.
+
+  template<typename T> void write_binary(std::ostream& os, const T& value);
+  template<typename T> void read_binary(std::istream& is, T& value);
+
+  namespace detail {
+    template<typename T> struct is_std_vector : std::false_type {};
+    template<typename T, typename A> struct is_std_vector<std::vector<T, A>> : std::true_type {};
+    template<typename T> struct is_std_array : std::false_type {};
+    template<typename T, size_t N> struct is_std_array<std::array<T, N>> : std::true_type {};
+    template<typename T> struct is_string_map : std::false_type {};
+    template<typename V> struct is_string_map<std::unordered_map<std::string, V>> : std::true_type {};
+    template<typename T> struct is_variant : std::false_type {};
+    template<typename... Ts> struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+    template<typename V, size_t I = 0> void read_variant(std::istream& is, V& value, size_t index) {
+      if constexpr (I < std::variant_size_v<V>) {
+        if (index == I) {
+          std::variant_alternative_t<I, V> alternative;
+          read_binary(is, alternative);
+          value = std::move(alternative);
+        } else {
+          read_variant<V, I+1>(is, value, index);
+        }
+      } else {
+        is.setstate(std::ios::failbit);
+      }
+    }
+  }
+
+  // generic implementation for arithmetic types, strings, std::array, std::vector, std::variant and maps with string keys.
+  // Other types need an overload, see the overloads for the geometry types below
+  template<typename T> void write_binary(std::ostream& os, const T& value) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      write_binary(os, uint64_t(value.size()));
+      os.write(value.data(), value.size());
+    } else if constexpr (detail::is_std_array<T>::value) {
+      if constexpr (std::is_arithmetic_v<typename T::value_type>)
+        os.write(reinterpret_cast<const char*>(value.data()), sizeof(T));
+      else
+        for (auto& v : value) write_binary(os, v);
+    } else if constexpr (detail::is_std_vector<T>::value) {
+      write_binary(os, uint64_t(value.size()));
+      using V = typename T::value_type;
+      if constexpr (std::is_same_v<V, bool>) {
+        for (bool v : value) write_binary(os, v);
+      } else if constexpr (std::is_trivially_copyable_v<V> && (std::is_arithmetic_v<V> || detail::is_std_array<V>::value)) {
+        // one write for the complete buffer
+        os.write(reinterpret_cast<const char*>(value.data()), value.size()*sizeof(V));
+      } else {
+        for (auto& v : value) write_binary(os, v);
+      }
+    } else if constexpr (detail::is_variant<T>::value) {
+      write_binary(os, uint64_t(value.index()));
+      std::visit([&os](auto& v) { write_binary(os, v); }, value);
+    } else if constexpr (detail::is_string_map<T>::value) {
+      write_binary(os, uint64_t(value.size()));
+      for (auto& [key, v] : value) {
+        write_binary(os, key);
+        write_binary(os, v);
+      }
+    } else {
+      static_assert(sizeof(T)==0, "No binary serialisation available for this type");
+    }
+  }
+  template<typename T> void read_binary(std::istream& is, T& value) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      uint64_t n; read_binary(is, n);
+      if (!is) return;
+      value.resize(n);
+      is.read(value.data(), n);
+    } else if constexpr (detail::is_std_array<T>::value) {
+      if constexpr (std::is_arithmetic_v<typename T::value_type>)
+        is.read(reinterpret_cast<char*>(value.data()), sizeof(T));
+      else
+        for (auto& v : value) read_binary(is, v);
+    } else if constexpr (detail::is_std_vector<T>::value) {
+      uint64_t n; read_binary(is, n);
+      if (!is) return;
+      using V = typename T::value_type;
+      value.clear();
+      if constexpr (std::is_same_v<V, bool>) {
+        value.reserve(n);
+        for (uint64_t i=0; i<n && is; ++i) { bool v; read_binary(is, v); value.push_back(v); }
+      } else if constexpr (std::is_trivially_copyable_v<V> && (std::is_arithmetic_v<V> || detail::is_std_array<V>::value)) {
+        value.resize(n);
+        is.read(reinterpret_cast<char*>(value.data()), n*sizeof(V));
+      } else {
+        value.resize(n);
+        for (auto& v : value) { if (!is) break; read_binary(is, v); }
+      }
+    } else if constexpr (detail::is_variant<T>::value) {
+      uint64_t index; read_binary(is, index);
+      if (!is) return;
+      detail::read_variant(is, value, index);
+    } else if constexpr (detail::is_string_map<T>::value) {
+      uint64_t n; read_binary(is, n);
+      value.clear();
+      for (uint64_t i=0; i<n && is; ++i) {
+        std::string key; read_binary(is, key);
+        read_binary(is, value[key]);
+      }
+    } else {
+      static_assert(sizeof(T)==0, "No binary serialisation available for this type");
+    }
+  }
+
+  // overloads for the types in common.hpp
+  void write_binary(std::ostream& os, const AttributeTable& value);
+  void read_binary(std::istream& is, AttributeTable& value);
+  void write_binary(std::ostream& os, const Box& value);
+  void read_binary(std::istream& is, Box& value);
+  void write_binary(std::ostream& os, const LinearRing& value);
+  void read_binary(std::istream& is, LinearRing& value);
+  void write_binary(std::ostream& os, const Segment& value);
+  void read_binary(std::istream& is, Segment& value);
+  void write_binary(std::ostream& os, const LineString& value);
+  void read_binary(std::istream& is, LineString& value);
+  void write_binary(std::ostream& os, const TriangleCollection& value);
+  void read_binary(std::istream& is, TriangleCollection& value);
+  void write_binary(std::ostream& os, const MultiTriangleCollection& value);
+  void read_binary(std::istream& is, MultiTriangleCollection& value);
+  void write_binary(std::ostream& os, const SegmentCollection& value);
+  void read_binary(std::istream& is, SegmentCollection& value);
+  void write_binary(std::ostream& os, const PointCollection& value);
+  void read_binary(std::istream& is, PointCollection& value);
+  void write_binary(std::ostream& os, const PointCloud& value);
+  void read_binary(std::istream& is, PointCloud& value);
+  void write_binary(std::ostream& os, const LineStringCollection& value);
+  void read_binary(std::istream& is, LineStringCollection& value);
+  void write_binary(std::ostream& os, const LinearRingCollection& value);
+  void read_binary(std::istream& is, LinearRingCollection& value);
+  void write_binary(std::ostream& os, const PackedRingCollection& value);
+  void read_binary(std::istream& is, PackedRingCollection& value);
+  void write_binary(std::ostream& os, const PackedLineStringCollection& value);
+  void read_binary(std::istream& is, PackedLineStringCollection& value);
+  void write_binary(std::ostream& os, const PackedLinearRingCollection& value);
+  void read_binary(std::istream& is, PackedLinearRingCollection& value);
+  void write_binary(std::ostream& os, const Mesh& value);
+  void read_binary(std::istream& is, Mesh& value);
+  void write_binary(std::ostream& os, const IndexedMesh& value);
+  void read_binary(std::istream& is, IndexedMesh& value);
+  void write_binary(std::ostream& os, const DateTime& value);
+  void read_binary(std::istream& is, DateTime& value);
+
+  // Maps the types that can be stored in terminals to a serialiser. Types are identified by a name in the serialised data.
+  // The types from common.hpp are registered by default, plugins can register their own types with register_type<T>()
+  class SerialiserRegistry {
+    struct Serialiser {
+      std::string name;
+      std::function<void(std::ostream&, const std::any&)> write;
+      std::function<std::any(std::istream&)> read;
+    };
+    std::unordered_map<std::type_index, Serialiser> serialisers_;
+    std::unordered_map<std::string, std::type_index> types_;
+
+    SerialiserRegistry();
+
+    public:
+    static SerialiserRegistry& get();
+
+    template<typename T> void register_type(const std::string& name) {
+      Serialiser s;
+      s.name = name;
+      s.write = [](std::ostream& os, const std::any& value) {
+        write_binary(os, std::any_cast<const T&>(value));
+      };
+      s.read = [](std::istream& is) {
+        T value;
+        read_binary(is, value);
+        return std::any(std::move(value));
+      };
+      serialisers_[typeid(T)] = s;
+      types_.insert_or_assign(name, std::type_index(typeid(T)));
+    }
+    bool can_serialise(std::type_index type) const;
+    // name of a registered type, throws if the type is not registered
+    const std::string& get_name(std::type_index type) const;
+    std::type_index get_type(const std::string& name) const;
+
+    // write the type name followed by the value, an empty std::any is written as an empty type name
+    void write(std::ostream& os, const std::any& value) const;
+    std::any read(std::istream& is) const;
+  };
+
+}
@@ -297,6 +297,7 @@ void hudPainter::render(glm::mat4 & model, glm::mat4 & view, glm::mat4 & project
 void Painter::set_attribute(std::string name, GLfloat* data, size_t n, size_t stride) {
     if(name == "position") {
         subdata_pairs.clear();
+        index_count = 0;
         bbox.clear();
         for(size_t i=0; i<n/3; i++) {
             bbox.add(&data[i*3]);
@@ -323,6 +324,7 @@ bool Painter::has_subdata() {
 void Painter::set_geometry(GeometryCollection<vec3f>& geoms) {
     if (geoms.size()==0) return;
     subdata_pairs.clear();
+    index_count = 0;
     bbox.clear();
     
     attributes["position"]->reserve_data<GLfloat>(geoms.vertex_count(), geoms.dimension());
@@ -339,6 +341,7 @@ void Painter::set_geometry(GeometryCollection<vec3f>& geoms) {
 void Painter::set_geometry(GeometryCollection<arr3f>& geoms) {
     if (geoms.size()==0) return;
     subdata_pairs.clear();
+    index_count = 0;
     bbox.clear();
     bbox.add(geoms.box());
     
@@ -349,6 +352,7 @@ void Painter::set_geometry(GeometryCollection<arr3f>& geoms) {
 void Painter::set_geometry(GeometryCollection< std::array<arr3f,3> >& geoms) {
     if (geoms.size()==0) return;
     subdata_pairs.clear();
+    index_count = 0;
     bbox.clear();
     bbox.add(geoms.box());
     
@@ -359,6 +363,7 @@ void Painter::set_geometry(GeometryCollection< std::array<arr3f,3> >& geoms) {
 void Painter::set_geometry(GeometryCollection< std::array<arr3f,2> >& geoms) {
     if (geoms.size()==0) return;
     subdata_pairs.clear();
+    index_count = 0;
     bbox.clear();
     bbox.add(geoms.box());
     
@@ -366,8 +371,55 @@ void Painter::set_geometry(GeometryCollection< std::array<arr3f,2> >& geoms) {
   
     enable_attribute("position");
 }
+void Painter::set_geometry(PointCloud& geoms) {
+    if (geoms.size()==0) return;
+    subdata_pairs.clear();
+    index_count = 0;
+    bbox.clear();
+    bbox.add(geoms.box());
+
+    // the cloud stores its coordinates in separate columns, interleave them only for the upload
+    vec3f vertices(geoms.size());
+    for (size_t i=0; i<geoms.size(); ++i)
+        vertices[i] = {geoms.x()[i], geoms.y()[i], geoms.z()[i]};
+    attributes["position"]->set_data(vertices[0].data(), vertices.size(), 3);
+  
+    enable_attribute("position");
+}
+void Painter::set_geometry(PackedRingCollection& geoms) {
+    if (geoms.vertex_count()==0) return;
+    subdata_pairs.clear();
+    index_count = 0;
+    bbox.clear();
+    bbox.add(geoms.box());
+
+    attributes["position"]->set_data(geoms.get_data_ptr(), geoms.vertex_count(), geoms.dimension());
+    for (size_t i=0; i<geoms.size(); ++i) {
+        subdata_pairs.push_back(std::make_pair(geoms.offsets()[i], geoms.ring_size(i)));
+    }
+    enable_attribute("position");
+}
+void Painter::set_geometry(IndexedMesh& mesh) {
+    if (mesh.vertex_count()==0) return;
+    subdata_pairs.clear();
+    bbox.clear();
+    bbox.add(mesh.box());
+
+    attributes["position"]->set_data(mesh.get_data_ptr(), mesh.vertex_count(), mesh.dimension());
+    enable_attribute("position");
+
+    auto indices = mesh.triangle_indices();
+    glBindVertexArray(mVertexArray);
+    if (mIndexBuffer==0)
+        glGenBuffers(1, &mIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    index_count = indices.size();
+}
 void Painter::begin_sub_geometries(size_t vertex_count, size_t dim) {
     subdata_pairs.clear();
+    index_count = 0;
     bbox.clear();
     attributes["position"]->reserve_data<GLfloat>(vertex_count, dim);
 }
@@ -386,6 +438,7 @@ void Painter::clear_attribute(const std::string name) {
     if(name == "position"){
         bbox.clear();
         subdata_pairs.clear();
+        index_count = 0;
         attributes["position"]->set_data<GLfloat>(nullptr, 0, 0);
     }
     disable_attribute(name);
@@ -540,7 +593,9 @@ void Painter::render(glm::mat4 & model, glm::mat4 & view, glm::mat4 & projection
 
     glBindVertexArray(mVertexArray);
     if (attributes["position"]->get_length()>0) {
-        if(has_subdata()){
+        if(index_count>0){
+            glDrawElements(draw_mode, index_count, GL_UNSIGNED_INT, nullptr);
+        } else if(has_subdata()){
             for (auto& [offset, len] : subdata_pairs) {
                 glDrawArrays(draw_mode, offset, len);
             }
@@ -327,6 +327,11 @@ class Painter : public BasePainter {
     void set_geometry(GeometryCollection<arr3f>& geoms);
     void set_geometry(GeometryCollection< std::array<arr3f,3> >& geoms);
     void set_geometry(GeometryCollection< std::array<arr3f,2> >& geoms);
+    void set_geometry(PointCloud& geoms);
+    // uploads all rings with a single buffer upload, each ring is drawn separately
+    void set_geometry(PackedRingCollection& geoms);
+    // uploads the vertices and the triangle indices of the mesh, the mesh is drawn with glDrawElements
+    void set_geometry(IndexedMesh& mesh);
     
     void begin_sub_attributes(std::string& name, size_t element_count, size_t stride);
     void set_sub_attributes(std::string& name, GLfloat* data, size_t count, size_t& offset);
@@ -347,8 +352,13 @@ class Painter : public BasePainter {
     void short_gui();
     
 
+    ~Painter() { if(mIndexBuffer) glDeleteBuffers(1, &mIndexBuffer); }
+
     private:
     std::vector<std::pair<size_t,size_t>> subdata_pairs;
+    // element buffer with the indices of an IndexedMesh, only used if index_count>0
+    GLuint mIndexBuffer=0;
+    size_t index_count=0;
     void init();
     geoflow::Box bbox;
     std::weak_ptr<Texture1D> texture;
@@ -0,0 +1,75 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// run_all_async() runs the flowchart on a background thread and reports errors of the run
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+class ThrowNode : public Node {
+  public:
+  using Node::Node;
+  void init() { add_input("x", typeid(float)); }
+  void process() { throw gfException("ThrowNode failed"); }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<ThrowNode>("Throw");
+  registers.emplace(R);
+
+  for (size_t n_threads : {1, 4}) {
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    auto a = N.create_node(R, "Number");
+    auto square = N.create_node(R, "Square");
+    connect(a, square, "value", "x");
+    set_param(*a, "value", 3);
+    set_param(*square, "sleep_ms", 100);
+    auto square_2 = N.create_node(R, "Square");
+    connect(square, square_2, "y", "x");
+
+    GF_CHECK(N.run_all_async());
+    GF_CHECK(N.is_running());
+    // only one run at a time
+    GF_CHECK(!N.run_all_async());
+    // the GUI thread can check if an input has data while its producer runs
+    GF_CHECK(!square_2->input("x").is_published());
+    N.wait();
+    GF_CHECK(!N.is_running());
+    GF_CHECK(N.get_run_error().empty());
+    GF_CHECK(square->output("y").get<float>() == 9);
+    GF_CHECK(square_2->input("x").is_published());
+    GF_CHECK(square_2->output("y").get<float>() == 81);
+
+    // a failing node ends the run with an error, the next run starts fresh
+    auto thrower = N.create_node(R, "Throw");
+    connect(square, thrower, "y", "x");
+    GF_CHECK(N.run_all_async());
+    N.wait();
+    GF_CHECK(N.get_run_error().find("ThrowNode failed") != std::string::npos);
+    N.remove_node(thrower);
+    thrower.reset();
+    GF_CHECK(N.run_all_async());
+    N.wait();
+    GF_CHECK(N.get_run_error().empty());
+  }
+
+  return failures();
+}
@@ -0,0 +1,132 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// AttributeTable must keep the attribute values through conversions, and slices must share their data until they
+// are modified
+
+#include <sstream>
+#include <geoflow/common.hpp>
+#include <geoflow/serialisation.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+const size_t n_rows = 100;
+
+AttributeMap test_attributes() {
+  AttributeMap attributes;
+  for (size_t i=0; i<n_rows; ++i) {
+    attributes["flag"].push_back(bool(i%3 == 0));
+    attributes["count"].push_back(int(i)-50);
+    attributes["height"].push_back(float(i)*0.5f);
+    attributes["class"].push_back(std::string(i%2 ? "roof" : "wall"));
+  }
+  return attributes;
+}
+
+void test_conversion() {
+  auto attributes = test_attributes();
+  AttributeTable table(attributes);
+  GF_CHECK(table.size() == n_rows && table.column_count() == 4);
+  GF_CHECK(table.column("count").type() == AttributeTypeInt);
+  GF_CHECK(table.column("class").type() == AttributeTypeString);
+  // strings are dictionary encoded
+  GF_CHECK(table.column("class").dictionary().size() == 2);
+  GF_CHECK(table.column("height").floats()[7] == 3.5f);
+  GF_CHECK(table.to_attribute_map() == attributes);
+
+  // disk cache round trip
+  auto& serialisers = SerialiserRegistry::get();
+  std::stringstream ss;
+  serialisers.write(ss, std::any(table));
+  auto read = std::any_cast<AttributeTable>(serialisers.read(ss));
+  GF_CHECK(read.column_names() == table.column_names());
+  GF_CHECK(read.to_attribute_map() == attributes);
+
+  // a value of another type is rejected
+  bool thrown = false;
+  try { table.column("count").push_back(1.f); } catch (const std::invalid_argument&) { thrown = true; }
+  GF_CHECK(thrown);
+}
+
+void test_nulls() {
+  AttributeTable table;
+  auto& column = table.add_column("name", AttributeTypeString);
+  column.push_back(std::string("a"));
+  column.push_null();
+  column.push_back(std::string("b"));
+  GF_CHECK(column.size() == 3 && column.has_nulls());
+  GF_CHECK(!column.is_null(0) && column.is_null(1) && !column.is_null(2));
+  GF_CHECK(!column.get(1).has_value());
+  GF_CHECK(std::get<std::string>(*column.get(2)) == "b");
+  // nulls become default values in an AttributeMap
+  GF_CHECK(std::get<std::string>(table.to_attribute_map().at("name")[1]) == "");
+  // a column that is added later is filled with nulls
+  auto& later = table.add_column("later", AttributeTypeInt);
+  GF_CHECK(later.size() == 3 && later.is_null(0) && later.is_null(2));
+}
+
+void test_slices() {
+  AttributeTable table(test_attributes());
+  auto slice = table.slice(10, 20);
+  GF_CHECK(slice.size() == 20);
+  // the slice views the data of the table
+  GF_CHECK(slice.column("count").ints() == table.column("count").ints() + 10);
+  GF_CHECK(std::get<int>(*slice.column("count").get(0)) == -40);
+  GF_CHECK(std::get<std::string>(*slice.column("class").get(1)) == "roof");
+  auto nested = slice.slice(5, 2);
+  GF_CHECK(std::get<float>(*nested.column("height").get(0)) == 7.5f);
+
+  // modifying the slice copies its part of the data, the table is unchanged
+  slice.column("count").push_back(1000);
+  GF_CHECK(slice.column("count").size() == 21);
+  GF_CHECK(slice.column("count").ints() != table.column("count").ints() + 10);
+  GF_CHECK(std::get<int>(*slice.column("count").get(20)) == 1000);
+  GF_CHECK(std::get<int>(*slice.column("count").get(0)) == -40);
+  GF_CHECK(table.column("count").size() == n_rows);
+  GF_CHECK(std::get<int>(*table.column("count").get(30)) == -20);
+  // the other columns of the slice still share their data
+  GF_CHECK(slice.column("height").floats() == table.column("height").floats() + 10);
+
+  // copies share their data until one of them is modified
+  auto copy = table;
+  GF_CHECK(copy.column("flag").bools() == table.column("flag").bools());
+  copy.column("flag").push_back(true);
+  GF_CHECK(copy.column("flag").bools() != table.column("flag").bools());
+  GF_CHECK(table.column("flag").size() == n_rows && copy.column("flag").size() == n_rows+1);
+
+  // slices with nulls keep them
+  AttributeTable with_nulls;
+  auto& column = with_nulls.add_column("x", AttributeTypeFloat);
+  for (size_t i=0; i<10; ++i) {
+    if (i%4 == 0) column.push_null();
+    else column.push_back(float(i));
+  }
+  auto null_slice = with_nulls.slice(3, 6);
+  GF_CHECK(null_slice.column("x").is_null(1) && null_slice.column("x").is_null(5));
+  null_slice.column("x").push_back(1.f);
+  GF_CHECK(null_slice.column("x").is_null(1) && !null_slice.column("x").is_null(6));
+  GF_CHECK(std::get<float>(*null_slice.column("x").get(0)) == 3.f);
+}
+
+int main() {
+  test_conversion();
+  test_nulls();
+  test_slices();
+  return failures();
+}
@@ -0,0 +1,112 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// the bounding boxes of all geometry types must match the box of their vertices, for every input size
+
+#include <geoflow/common.hpp>
+#include <geoflow/kernels.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+const size_t max_n = 70;
+
+// deterministic vertices with the extremes of each component at different positions
+vec3f test_vertices(size_t n) {
+  vec3f v(n);
+  for (size_t i=0; i<n; ++i)
+    v[i] = {float(int((i*37) % 101) - 50), float(int((i*53) % 97) - 40) * 0.5f, float(int((i*11) % 89)) + 0.25f};
+  return v;
+}
+
+// scalar reference
+Box reference_box(const vec3f& vertices) {
+  Box box;
+  for (auto& p : vertices) box.add(p);
+  return box;
+}
+
+bool same_box(const Box& a, const Box& b) {
+  if (a.isEmpty() || b.isEmpty()) return a.isEmpty() == b.isEmpty();
+  return a.min() == b.min() && a.max() == b.max();
+}
+
+void test_minmax_xyz() {
+  for (size_t n=0; n<=max_n; ++n) {
+    auto v = test_vertices(n);
+    float vmin[3] = {1e9, 1e9, 1e9}, vmax[3] = {-1e9, -1e9, -1e9};
+    kernels::minmax_xyz(v.empty() ? nullptr : v[0].data(), n, vmin, vmax);
+    auto box = reference_box(v);
+    if (n == 0) {
+      GF_CHECK(vmin[0] == 1e9f && vmax[0] == -1e9f);
+    } else if (!GF_CHECK((arr3f{vmin[0], vmin[1], vmin[2]}) == box.min() && (arr3f{vmax[0], vmax[1], vmax[2]}) == box.max())) {
+      std::cerr << "minmax_xyz n=" << n << "\n";
+    }
+  }
+  // large enough to be split over threads
+  size_t n = 3000000;
+  vec3f v(n, {0, 0, 0});
+  v[17] = {-1, 0, 0};
+  v[n/2+5] = {0, 7, 0};
+  v[n-1] = {0, 0, -3};
+  float vmin[3], vmax[3];
+  kernels::minmax_xyz(v[0].data(), n, vmin, vmax);
+  GF_CHECK(vmin[0] == -1 && vmax[1] == 7 && vmin[2] == -3 && vmax[0] == 0);
+}
+
+void test_geometry_boxes() {
+  for (size_t n : {0, 1, 5, 8, 13, 67}) {
+    auto v = test_vertices(6*n);
+    auto expected = reference_box(v);
+
+    TriangleCollection triangles;
+    SegmentCollection segments;
+    PointCollection points;
+    for (size_t i=0; i<2*n; ++i) triangles.push_back({v[3*i], v[3*i+1], v[3*i+2]});
+    for (size_t i=0; i<3*n; ++i) segments.push_back({v[2*i], v[2*i+1]});
+    for (auto& p : v) points.push_back(p);
+    GF_CHECK(same_box(triangles.box(), expected));
+    GF_CHECK(same_box(segments.box(), expected));
+    GF_CHECK(same_box(points.box(), expected));
+
+    // rings and line strings of varying length
+    LineStringCollection lines;
+    LinearRingCollection rings;
+    for (size_t start=0, len=1; start<v.size(); start+=len, ++len) {
+      vec3f part(v.begin()+start, v.begin()+std::min(v.size(), start+len));
+      lines.push_back(part);
+      rings.push_back(part);
+    }
+    GF_CHECK(same_box(lines.box(), expected));
+    GF_CHECK(same_box(rings.box(), expected));
+
+    LinearRing ring;
+    for (auto& p : v) ring.push_back(p);
+    GF_CHECK(same_box(ring.box(), expected));
+    Box box;
+    box.add(v);
+    if (!GF_CHECK(same_box(box, expected)))
+      std::cerr << "geometry boxes n=" << n << "\n";
+  }
+}
+
+int main() {
+  test_minmax_xyz();
+  test_geometry_boxes();
+  return failures();
+}
@@ -0,0 +1,141 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// node results are written to the disk cache and read back through the SerialiserRegistry
+
+#include <sstream>
+
+#include "test_nodes.hpp"
+#include <geoflow/serialisation.hpp>
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs n points and a poly output with one attribute per point, counts how often it is processed
+class PointsNode : public Node {
+  int n_=3;
+  public:
+  static std::atomic<int> n_processed;
+  using Node::Node;
+  void init() {
+    add_output("points", typeid(PointCollection));
+    add_poly_output("attributes", {typeid(float), typeid(int)});
+    add_param(ParamInt(n_, "n", "Number of points"));
+  }
+  void process() {
+    ++n_processed;
+    PointCollection points;
+    for (int i=0; i<n_; ++i) points.push_back({float(i), 1, 2});
+    output("points").set(std::move(points));
+    auto& attributes = poly_output("attributes");
+    auto& height = attributes.add_vector("height", typeid(float));
+    for (int i=0; i<n_; ++i) height.push_back(float(i)+0.5f);
+    attributes.touch();
+  }
+};
+std::atomic<int> PointsNode::n_processed{0};
+
+// outputs its text parameter, which may refer to globals
+class TextNode : public Node {
+  std::string text_;
+  public:
+  static std::atomic<int> n_processed;
+  using Node::Node;
+  void init() {
+    add_output("text", typeid(std::string));
+    add_param(ParamString(text_, "text", "Text"));
+  }
+  void process() {
+    ++n_processed;
+    output("text").set(manager.substitute_globals(text_));
+  }
+};
+std::atomic<int> TextNode::n_processed{0};
+
+// run a fresh flowchart with one TextNode whose text has an unknown global, returns its cache key
+uint64_t run_text(NodeRegisterMap& registers, NodeRegisterHandle R, const std::string& cache_dir, const std::string& name) {
+  NodeManager N(registers);
+  N.cache_dir = cache_dir;
+  N.global_flowchart_params["name"] = std::make_shared<ParameterByValue<std::string>>(name, "name", "");
+  auto node = N.create_node(R, "Text");
+  node->use_disk_cache = true;
+  set_param<std::string>(*node, "text", "{{x}}/{{name}}");
+  N.run_all();
+  GF_CHECK(node->output("text").get<std::string>() == "{{x}}/" + name);
+  return node->compute_cache_key();
+}
+
+// run a fresh flowchart with one PointsNode and check its results
+void run_points(NodeRegisterMap& registers, NodeRegisterHandle R, const std::string& cache_dir, int n, int expected_n_processed) {
+  NodeManager N(registers);
+  N.cache_dir = cache_dir;
+  auto node = N.create_node(R, "Points");
+  node->use_disk_cache = true;
+  set_param(*node, "n", n);
+  N.run_all();
+
+  GF_CHECK(PointsNode::n_processed == expected_n_processed);
+  auto& points = node->output("points").get<const PointCollection&>();
+  if (GF_CHECK(points.size() == size_t(n)))
+    GF_CHECK(points.back()[0] == float(n-1));
+  auto& height = node->poly_output("attributes").sub_terminal("height");
+  if (GF_CHECK(height.size() == size_t(n))) {
+    for (int i=0; i<n; ++i)
+      GF_CHECK(height.get<float>(i) == float(i)+0.5f);
+  }
+}
+
+int main() {
+  TempFolder folder("test_disk_cache");
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<PointsNode>("Points");
+  R->register_node<TextNode>("Text");
+  registers.emplace(R);
+
+  // the first run computes the result, the second reads it from the cache and a parameter change computes it again
+  run_points(registers, R, folder.file("cache"), 3, 1);
+  run_points(registers, R, folder.file("cache"), 3, 1);
+  run_points(registers, R, folder.file("cache"), 5, 2);
+  run_points(registers, R, folder.file("cache"), 5, 2);
+
+  // the cache key of a parameter with an unknown global depends on the globals that are known
+  auto key_a = run_text(registers, R, folder.file("cache"), "a");
+  GF_CHECK(run_text(registers, R, folder.file("cache"), "a") == key_a);
+  GF_CHECK(TextNode::n_processed == 1);
+  GF_CHECK(run_text(registers, R, folder.file("cache"), "b") != key_a);
+  GF_CHECK(TextNode::n_processed == 2);
+
+  // round trip of a nested geometry type
+  MultiTriangleCollection mtc;
+  TriangleCollection tc;
+  tc.push_back({arr3f{1,2,3}, arr3f{4,5,6}, arr3f{7,8,9}});
+  mtc.push_back(tc);
+  AttributeMap attributes;
+  attributes["a"] = {attribute_value(1), attribute_value(std::string("x"))};
+  mtc.push_back(attributes);
+
+  auto& serialisers = SerialiserRegistry::get();
+  GF_CHECK(serialisers.can_serialise(typeid(MultiTriangleCollection)));
+  std::stringstream ss;
+  serialisers.write(ss, std::any(mtc));
+  auto result = std::any_cast<MultiTriangleCollection>(serialisers.read(ss));
+  GF_CHECK(result.tri_size() == 1);
+  GF_CHECK(result.tri_at(0)[0][2][1] == 8);
+  GF_CHECK(std::get<std::string>(result.attr_at(0).at("a")[1]) == "x");
+
+  return failures();
+}
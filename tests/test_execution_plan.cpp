@@ -0,0 +1,94 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// nodes are run in the order of the execution plan, and the progress of a run counts every node it processes
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  registers.emplace(R);
+
+  for (size_t n_threads : {1, 4}) {
+    // a diamond: a feeds b and c, which both feed d
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    auto a = N.create_node(R, "Number");
+    auto b = N.create_node(R, "Square");
+    auto c = N.create_node(R, "Square");
+    auto d = N.create_node(R, "Add");
+    auto e = N.create_node(R, "Square");
+    connect(a, b, "value", "x");
+    connect(a, c, "value", "x");
+    connect(b, d, "y", "a");
+    connect(c, d, "y", "b");
+    connect(d, e, "sum", "x");
+    set_param(*a, "value", 3);
+
+    GF_CHECK(N.run_all_async());
+    N.wait();
+    GF_CHECK(e->output("y").get<float>() == 324);
+    auto progress = N.get_progress();
+    if (!GF_CHECK(progress.first == 5 && progress.second == 5))
+      std::cerr << "n_threads=" << n_threads << " progress " << progress.first << "/" << progress.second << "\n";
+
+    // running a single node only processes its descendants
+    GF_CHECK(N.run(b) == 3);
+    GF_CHECK(e->output("y").get<float>() == 324);
+    GF_CHECK(b->get_metrics().calls == 2 && c->get_metrics().calls == 1 && a->get_metrics().calls == 1);
+
+    // the plan is rebuilt when the graph changes
+    auto f = N.create_node(R, "Square");
+    connect(e, f, "y", "x");
+    N.run_all();
+    GF_CHECK(f->output("y").get<float>() == 324*324);
+  }
+
+  // nodes cloned into a flowchart after it has run are part of the next run
+  NodeManager source(registers), target(registers);
+  auto x = source.create_node(R, "Number");
+  auto x_squared = source.create_node(R, "Square");
+  connect(x, x_squared, "value", "x");
+  set_param(*x, "value", 5);
+  target.create_node(R, "Number");
+  GF_CHECK(target.run_all() == 1);
+  target.clone_nodes(source);
+  GF_CHECK(target.get_nodes().size() == 3);
+  GF_CHECK(target.run_all() == 3);
+  for (auto& [name, node] : target.get_nodes()) {
+    if (node->get_type_name() == "Square")
+      GF_CHECK(node->output("y").get<float>() == 25);
+  }
+
+  // a node of another flowchart can not be run
+  NodeManager N(registers), other(registers);
+  N.create_node(R, "Number");
+  auto foreign = other.create_node(R, "Number");
+  other.name_node(foreign, "foreign");
+  bool thrown = false;
+  try { 
+    N.run(foreign);
+  } catch (const gfException& e) { 
+    thrown = std::string(e.what()).find("foreign") != std::string::npos;
+  }
+  GF_CHECK(thrown);
+
+  return failures();
+}
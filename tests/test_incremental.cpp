@@ -0,0 +1,104 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// incremental runs only process the nodes whose parameters or inputs changed
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs its text parameter, which may refer to globals
+class TextNode : public Node {
+  std::string text_;
+  public:
+  using Node::Node;
+  void init() {
+    add_output("text", typeid(std::string));
+    add_param(ParamString(text_, "text", "Text"));
+  }
+  void process() { output("text").set(manager.substitute_globals(text_)); }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<TextNode>("Text");
+  registers.emplace(R);
+
+  for (size_t n_threads : {1, 4}) {
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    N.incremental = true;
+    auto a = N.create_node(R, "Number");
+    auto b = N.create_node(R, "Number");
+    auto add = N.create_node(R, "Add");
+    auto square = N.create_node(R, "Square");
+    auto c = N.create_node(R, "Number");
+    auto square_c = N.create_node(R, "Square");
+    connect(a, add, "value", "a");
+    connect(b, add, "value", "b");
+    connect(add, square, "sum", "x");
+    connect(c, square_c, "value", "x");
+    set_param(*a, "value", 2);
+    set_param(*b, "value", 3);
+    set_param(*c, "value", 4);
+
+    GF_CHECK(N.run_all() == 6);
+    GF_CHECK(square->output("y").get<float>() == 25);
+    GF_CHECK(square_c->output("y").get<float>() == 16);
+
+    // nothing changed
+    GF_CHECK(N.run_all() == 0);
+    GF_CHECK(square->output("y").get<float>() == 25);
+    GF_CHECK(square_c->output("y").get<float>() == 16);
+
+    // only b and its descendants are processed
+    set_param(*b, "value", 1);
+    GF_CHECK(N.run_all() == 3);
+    GF_CHECK(a->get_metrics().calls == 1);
+    GF_CHECK(add->get_metrics().calls == 2);
+    GF_CHECK(square->output("y").get<float>() == 9);
+    GF_CHECK(square_c->output("y").get<float>() == 16);
+    GF_CHECK(square_c->get_metrics().calls == 1);
+
+    // without incremental mode every node is processed again
+    N.incremental = false;
+    GF_CHECK(N.run_all() == 6);
+    GF_CHECK(square->output("y").get<float>() == 9);
+  }
+
+  // placeholders that are not a string global are kept, a string global is substituted once
+  NodeManager N(registers);
+  N.global_flowchart_params["name"] = std::make_shared<ParameterByValue<std::string>>("{{name}}", "name", "");
+  N.global_flowchart_params["i"] = std::make_shared<ParameterByValue<int>>(1, "i", "");
+  GF_CHECK(N.substitute_globals("}} {{x}} {{i}}/{{name}}.txt") == "}} {{x}} {{i}}/{{name}}.txt");
+  static_cast<ParameterByValue<std::string>&>(*N.global_flowchart_params["name"]).set("a");
+  GF_CHECK(N.substitute_globals("{{x}}/{{name}}_{{name}}.txt") == "{{x}}/a_a.txt");
+
+  // a parameter with an unknown global does not stop the signature from being computed
+  N.incremental = true;
+  auto text = N.create_node(R, "Text");
+  set_param<std::string>(*text, "text", "{{x}}/{{name}}");
+  GF_CHECK(N.run_all() == 1);
+  GF_CHECK(text->output("text").get<std::string>() == "{{x}}/a");
+  GF_CHECK(N.run_all() == 0);
+  static_cast<ParameterByValue<std::string>&>(*N.global_flowchart_params["name"]).set("b");
+  GF_CHECK(N.run_all() == 1);
+  GF_CHECK(text->output("text").get<std::string>() == "{{x}}/b");
+
+  return failures();
+}
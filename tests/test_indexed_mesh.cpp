@@ -0,0 +1,176 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// IndexedMesh must keep the geometry of the triangles and polygons it is converted from and back to
+
+#include <cmath>
+#include <sstream>
+#include <geoflow/common.hpp>
+#include <geoflow/serialisation.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+LinearRing make_ring(const vec3f& vertices) {
+  LinearRing ring;
+  for (auto& p : vertices) ring.push_back(p);
+  return ring;
+}
+
+// summed area of the triangles in the xy plane, negative for clockwise triangles
+double signed_area(const IndexedMesh& mesh, const std::vector<uint32_t>& tri_indices) {
+  auto& v = mesh.vertices();
+  double area = 0;
+  for (size_t i=0; i+2<tri_indices.size(); i+=3) {
+    auto &a = v[tri_indices[i]], &b = v[tri_indices[i+1]], &c = v[tri_indices[i+2]];
+    area += 0.5 * ((double(b[0])-a[0])*(double(c[1])-a[1]) - (double(b[1])-a[1])*(double(c[0])-a[0]));
+  }
+  return area;
+}
+
+void test_triangles() {
+  TriangleCollection triangles;
+  triangles.set_offset({100., 200., 0.});
+  triangles.push_back({arr3f{0,0,0}, arr3f{1,0,0}, arr3f{1,1,0}});
+  triangles.push_back({arr3f{0,0,0}, arr3f{1,1,0}, arr3f{0,1,0}});
+  IndexedMesh mesh(triangles);
+  // the shared vertices are merged
+  GF_CHECK(mesh.vertex_count() == 4);
+  GF_CHECK(mesh.is_triangle_mesh() && mesh.polygon_count() == 2);
+  GF_CHECK(mesh.offset() == triangles.offset());
+  auto back = mesh.to_triangle_collection();
+  GF_CHECK(back.offset() == triangles.offset());
+  GF_CHECK(back.size() == 2 && back[0] == triangles[0] && back[1] == triangles[1]);
+
+  // disk cache round trip
+  auto& serialisers = SerialiserRegistry::get();
+  std::stringstream ss;
+  serialisers.write(ss, std::any(mesh));
+  auto read = std::any_cast<IndexedMesh>(serialisers.read(ss));
+  GF_CHECK(read.vertices() == mesh.vertices() && read.indices() == mesh.indices());
+  GF_CHECK(read.offset() == mesh.offset() && read.labels() == mesh.labels());
+}
+
+void test_mesh() {
+  Mesh mesh;
+  auto square = make_ring({{0,0,0}, {4,0,0}, {4,4,0}, {0,4,0}});
+  square.interior_rings().push_back({{1,1,0}, {1,2,0}, {2,2,0}, {2,1,0}});
+  mesh.push_polygon(square, 3);
+  // shares an edge with the square, but is stored relative to another offset
+  auto next = make_ring({{0,0,0}, {2,0,0}, {2,4,0}, {0,4,0}});
+  next.set_offset({4., 0., 0.});
+  mesh.push_polygon(next, 5);
+
+  IndexedMesh indexed(mesh);
+  GF_CHECK(indexed.polygon_count() == 2 && indexed.ring_count() == 3);
+  GF_CHECK(indexed.offset() == square.offset());
+  // 4 + 4 vertices for the square and its hole, 2 new ones for the second polygon
+  GF_CHECK(indexed.vertex_count() == 10);
+  GF_CHECK(indexed.labels() == (std::vector<int>{3, 5}));
+
+  auto back = indexed.to_mesh();
+  auto& polygons = back.get_polygons();
+  if (GF_CHECK(polygons.size() == 2)) {
+    GF_CHECK(vec3f(polygons[0]) == vec3f(square));
+    GF_CHECK(polygons[0].interior_rings() == square.interior_rings());
+    // the second polygon was moved onto the offset of the first
+    GF_CHECK(polygons[1].offset() == square.offset());
+    GF_CHECK(vec3f(polygons[1]) == (vec3f{{4,0,0}, {6,0,0}, {6,4,0}, {4,4,0}}));
+  }
+  GF_CHECK(back.get_labels() == mesh.get_labels());
+
+  // the hole is left out of the triangulation, 8 triangles for the square with its hole and 2 for the other polygon
+  auto tri_indices = indexed.triangle_indices();
+  GF_CHECK(tri_indices.size() == 30);
+  GF_CHECK(std::abs(signed_area(indexed, tri_indices) - (16 - 1 + 8)) < 1e-6);
+  auto& v = indexed.vertices();
+  for (size_t t=0; t+2<tri_indices.size(); t+=3) {
+    auto &a = v[tri_indices[t]], &b = v[tri_indices[t+1]], &c = v[tri_indices[t+2]];
+    float cx = (a[0]+b[0]+c[0])/3, cy = (a[1]+b[1]+c[1])/3;
+    GF_CHECK(!(cx > 1 && cx < 2 && cy > 1 && cy < 2));
+  }
+}
+
+void test_holes() {
+  // a concave polygon with two holes, with either orientation of the holes
+  for (bool reverse_holes : {false, true}) {
+    Mesh mesh;
+    auto polygon = make_ring({{0,0,0}, {10,0,0}, {10,10,0}, {5,10,0}, {5,4,0}, {4,4,0}, {4,10,0}, {0,10,0}});
+    vec3f hole_a = {{1,1,0}, {3,1,0}, {3,3,0}, {1,3,0}};
+    vec3f hole_b = {{6,6,0}, {8,6,0}, {7,8,0}};
+    if (reverse_holes) {
+      std::reverse(hole_a.begin(), hole_a.end());
+      std::reverse(hole_b.begin(), hole_b.end());
+    }
+    polygon.interior_rings() = {hole_a, hole_b};
+    mesh.push_polygon(polygon, 0);
+    IndexedMesh indexed(mesh);
+    auto tri_indices = indexed.triangle_indices();
+    // n + 2*h - 2 triangles for n vertices and h holes
+    GF_CHECK(tri_indices.size() == 3*(15 + 2*2 - 2));
+    auto area = signed_area(indexed, tri_indices);
+    if (!GF_CHECK(std::abs(area - (100 - 6 - 4 - 2)) < 1e-6))
+      std::cerr << "reverse_holes=" << reverse_holes << " area=" << area << "\n";
+  }
+}
+
+void test_triangulation() {
+  // concave polygons, a fan from the first vertex would cover area outside of them
+  std::vector<vec3f> rings = {
+    {{0,0,0}, {4,0,0}, {4,1,0}, {1,1,0}, {1,4,0}, {0,4,0}},
+    {{1,1,0}, {1,4,0}, {0,4,0}, {0,0,0}, {4,0,0}, {4,1,0}},
+    {{0,0,0}, {2,1,0}, {4,0,0}, {4,4,0}, {2,3,0}, {0,4,0}},
+  };
+  std::vector<double> areas = {7, 7, 12};
+  for (size_t i=0; i<rings.size(); ++i) {
+    for (bool clockwise : {false, true}) {
+      auto ring = rings[i];
+      if (clockwise) std::reverse(ring.begin(), ring.end());
+      Mesh mesh;
+      auto polygon = make_ring(ring);
+      mesh.push_polygon(polygon, 0);
+      IndexedMesh indexed(mesh);
+      auto tri_indices = indexed.triangle_indices();
+      GF_CHECK(tri_indices.size() == 3*(ring.size()-2));
+      // every triangle has the orientation of the ring, so the areas add up to the polygon area
+      auto area = signed_area(indexed, tri_indices);
+      if (!GF_CHECK(std::abs(area - (clockwise ? -areas[i] : areas[i])) < 1e-6))
+        std::cerr << "ring " << i << " clockwise=" << clockwise << " area=" << area << "\n";
+      auto& v = indexed.vertices();
+      for (size_t t=0; t+2<tri_indices.size(); t+=3) {
+        auto &a = v[tri_indices[t]], &b = v[tri_indices[t+1]], &c = v[tri_indices[t+2]];
+        double cross = (double(b[0])-a[0])*(double(c[1])-a[1]) - (double(b[1])-a[1])*(double(c[0])-a[0]);
+        GF_CHECK(clockwise ? cross < 0 : cross > 0);
+      }
+    }
+  }
+
+  // a vertical wall is projected on the plane it is closest to
+  Mesh wall;
+  auto polygon = make_ring({{0,0,0}, {4,0,0}, {4,0,1}, {1,0,1}, {1,0,4}, {0,0,4}});
+  wall.push_polygon(polygon, 0);
+  GF_CHECK(IndexedMesh(wall).to_triangle_collection().size() == 4);
+}
+
+int main() {
+  test_triangles();
+  test_mesh();
+  test_holes();
+  test_triangulation();
+  return failures();
+}
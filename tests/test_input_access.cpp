@@ -0,0 +1,130 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// get_ref<T>() reads the data of the connected output without copying, get<T>() copies and counts the copied bytes
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs a vector of n floats as a single element
+class VectorSourceNode : public Node {
+  int n_=1000;
+  public:
+  using Node::Node;
+  void init() {
+    add_output("values", typeid(std::vector<float>));
+    add_param(ParamInt(n_, "n", "Number of values"));
+  }
+  void process() { output("values").set(std::vector<float>(n_, 1.f)); }
+};
+
+// reads its input by reference or by value
+class VectorReaderNode : public Node {
+  bool by_value_=false;
+  public:
+  const std::vector<float>* ref = nullptr;
+  float sum = 0;
+  using Node::Node;
+  void init() {
+    add_input("values", typeid(std::vector<float>));
+    add_param(ParamBool(by_value_, "by_value", "Copy the input with get<T>()"));
+  }
+  void process() {
+    sum = 0;
+    if (by_value_) {
+      auto values = input("values").get<std::vector<float>>();
+      for (auto v : values) sum += v;
+    } else {
+      auto& values = input("values").get_ref<std::vector<float>>();
+      ref = &values;
+      for (auto v : values) sum += v;
+    }
+  }
+};
+
+// copies its input once and reads it once by reference
+class CopyOnceNode : public Node {
+  public:
+  using Node::Node;
+  void init() { add_input("values", typeid(std::vector<float>)); }
+  void process() {
+    auto copy = input("values").get<std::vector<float>>();
+    auto& ref = input("values").get_ref<std::vector<float>>();
+    (void)copy; (void)ref;
+  }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<VectorSourceNode>("VectorSource");
+  R->register_node<VectorReaderNode>("VectorReader");
+  R->register_node<CopyOnceNode>("CopyOnce");
+  registers.emplace(R);
+
+  for (bool by_value : {false, true}) {
+    NodeManager N(registers);
+    auto source = N.create_node(R, "VectorSource");
+    auto reader = N.create_node(R, "VectorReader");
+    set_param(*reader, "by_value", by_value);
+    GF_CHECK(connect(source, reader, "values", "values"));
+    N.run_all();
+    auto reader_node = static_cast<VectorReaderNode*>(reader.get());
+    GF_CHECK(reader_node->sum == 1000);
+    if (by_value) {
+#ifndef NDEBUG
+      GF_CHECK(reader->get_copied_bytes() >= 1000*sizeof(float));
+#else
+      GF_CHECK(reader->get_copied_bytes() == 0);
+#endif
+    } else {
+      // the reference points at the data in the output terminal
+      GF_CHECK(reader_node->ref == &source->output("values").get<const std::vector<float>&>());
+      GF_CHECK(reader->get_copied_bytes() == 0);
+    }
+  }
+
+  // only the copy is counted, by the shallow estimate of gfDataSize, and the count is reset for every run
+  {
+    NodeManager N(registers);
+    auto source = N.create_node(R, "VectorSource");
+    auto reader = N.create_node(R, "CopyOnce");
+    connect(source, reader, "values", "values");
+    for (int run=0; run<2; ++run) {
+      N.run_all();
+#ifndef NDEBUG
+      GF_CHECK(reader->get_copied_bytes() == sizeof(std::vector<float>) + 1000*sizeof(float));
+#else
+      GF_CHECK(reader->get_copied_bytes() == 0);
+#endif
+    }
+  }
+
+  // elements of vector outputs, with and without typed storage
+  NodeManager N(registers);
+  auto range = N.create_node(R, "Range");
+  auto square = N.create_node(R, "Square");
+  connect(range, square, "values", "x");
+  set_param(*range, "n", 3);
+  N.run_all();
+  auto& input = square->input("x");
+  GF_CHECK(input.get_ref<float>(2) == 2.f);
+  GF_CHECK(&input.get_ref<float>(1) == &input.get_ref<float>(1));
+
+  return failures();
+}
@@ -0,0 +1,154 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// run_all() does not process more nodes at the same time than fit in the memory budget, and learns the memory use
+// of each node
+
+#include "test_nodes.hpp"
+#include <geoflow/core_nodes.hpp>
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+const size_t buffer_size = 1<<18;
+
+class BufferNode : public Node {
+  public:
+  using Node::Node;
+  void init() { add_output("buffer", typeid(std::vector<float>)); }
+  void process() { output("buffer").set(std::vector<float>(buffer_size, 1.f)); }
+};
+
+// keeps track of how many nodes are processed at the same time
+class SleepNode : public Node {
+  public:
+  static std::atomic<int> n_running, max_running;
+  using Node::Node;
+  void init() { add_output("done", typeid(bool)); }
+  void process() {
+    int running = ++n_running;
+    int max = max_running;
+    while (running > max && !max_running.compare_exchange_weak(max, running));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    --n_running;
+    output("done").set(true);
+  }
+};
+std::atomic<int> SleepNode::n_running{0};
+std::atomic<int> SleepNode::max_running{0};
+
+// SleepNode with an input, so that it can be the first node of a nested flowchart
+class SleepItemNode : public SleepNode {
+  public:
+  using SleepNode::SleepNode;
+  void init() {
+    add_input("x", typeid(float));
+    SleepNode::init();
+  }
+};
+
+int test_budget(NodeRegisterMap& registers, NodeRegisterHandle R, size_t budget_kb) {
+  NodeManager N(registers);
+  N.n_threads = 8;
+  N.memory_budget_kb = budget_kb;
+  for (int i=0; i<8; ++i) {
+    N.create_node(R, "Sleep")->memory_estimate_kb = 400;
+  }
+  SleepNode::max_running = 0;
+  N.run_all();
+  if (budget_kb)
+    GF_CHECK(N.get_memory_report().deferred > 0);
+  return SleepNode::max_running;
+}
+
+// copies of one flowchart that run at the same time and share its budget
+int test_shared_budget(NodeRegisterMap& registers, NodeRegisterHandle R, size_t budget_kb) {
+  NodeManager N(registers);
+  N.memory_budget_kb = budget_kb;
+  std::vector<std::unique_ptr<NodeManager>> copies;
+  for (int c=0; c<3; ++c) {
+    copies.push_back(std::make_unique<NodeManager>(registers));
+    auto& copy = *copies.back();
+    copy.n_threads = 4;
+    copy.share_memory_budget(N);
+    for (int i=0; i<4; ++i) {
+      copy.create_node(R, "Sleep")->memory_estimate_kb = 400;
+    }
+  }
+  SleepNode::max_running = 0;
+  std::vector<std::thread> threads;
+  for (auto& copy : copies) {
+    threads.emplace_back([&copy]() { copy->run_all(); });
+  }
+  for (auto& thread : threads) thread.join();
+  return SleepNode::max_running;
+}
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<BufferNode>("Buffer");
+  R->register_node<SleepNode>("Sleep");
+  R->register_node<SleepItemNode>("SleepItem");
+  registers.emplace(R);
+  auto R_core = NodeRegister::create("Core");
+  R_core->register_node<nodes::core::NestNode>("NestedFlowchart");
+  registers.emplace(R_core);
+
+  GF_CHECK(test_budget(registers, R, 0) > 2);
+  GF_CHECK(test_budget(registers, R, 1000) <= 2);
+  GF_CHECK(test_budget(registers, R, 300) == 1);
+  GF_CHECK(test_shared_budget(registers, R, 0) > 2);
+  GF_CHECK(test_shared_budget(registers, R, 1000) <= 2);
+
+  TempFolder folder("test_memory_budget");
+
+  // once an item of a parallel NestNode has run, the other items run at the same time, even if they use less than 1 kB
+  {
+    NodeManager nested(registers);
+    auto sleep = nested.create_node(R, "SleepItem");
+    sleep->input_terminals.at("x")->set_marked(true);
+    sleep->output_terminals.at("done")->set_marked(true);
+    nested.dump_json(folder.file("nested.json"));
+
+    NodeManager N(registers);
+    N.memory_budget_kb = 1000;
+    auto range = N.create_node(R, "Range");
+    set_param(*range, "n", 8);
+    auto nest = N.create_node(R_core, "NestedFlowchart");
+    set_param<std::string>(*nest, "filepath", folder.file("nested.json"));
+    nest->post_parameter_load();
+    set_param(*nest, "use_parallel_processing", true);
+    set_param(*nest, "n_threads", 4);
+    connect(range, nest, "values", sleep->get_name()+".x");
+    SleepNode::max_running = 0;
+    N.run_all();
+    GF_CHECK(nest->vector_output(sleep->get_name()+".done").size() == 8);
+    GF_CHECK(SleepNode::max_running > 1);
+  }
+
+  // the learned estimate of a node is saved with the flowchart
+  NodeManager N(registers);
+  N.create_node(R, "Buffer");
+  N.run_all();
+  GF_CHECK(N.get_nodes().begin()->second->memory_estimate_kb >= buffer_size * sizeof(float) / 1024);
+  N.dump_json(folder.file("flowchart.json"));
+  NodeManager N_loaded(registers);
+  N_loaded.load_json(folder.file("flowchart.json"));
+  GF_CHECK(N_loaded.get_nodes().begin()->second->memory_estimate_kb == N.get_nodes().begin()->second->memory_estimate_kb);
+
+  return failures();
+}
@@ -0,0 +1,88 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// run_all() records metrics for every processed node and writes them as a Chrome trace
+
+#include <fstream>
+#include <sstream>
+#include <nlohmann/json.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+using json = nlohmann::json;
+
+int main() {
+  TempFolder folder("test_metrics");
+  NodeRegisterMap registers;
+  auto R = create_register();
+  registers.emplace(R);
+
+  for (size_t n_threads : {1, 4}) {
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    N.record_trace = true;
+    auto a = N.create_node(R, "Number");
+    auto square = N.create_node(R, "Square");
+    auto range = N.create_node(R, "Range");
+    N.name_node(a, "a");
+    N.name_node(square, "square");
+    N.name_node(range, "range");
+    connect(a, square, "value", "x");
+    set_param(*square, "sleep_ms", 20);
+    set_param(*range, "n", 100);
+    N.run_all();
+    N.run_all();
+
+    auto& metrics = square->get_metrics();
+    GF_CHECK(metrics.calls == 2);
+    GF_CHECK(metrics.wall_time_ms >= 20);
+    GF_CHECK(metrics.total_wall_time_ms >= 40);
+    GF_CHECK(metrics.output_bytes.at("y") >= sizeof(float));
+    GF_CHECK(range->get_metrics().output_bytes.at("values") >= 100*sizeof(float));
+
+    // the table lists every node that was processed
+    std::stringstream ss;
+    N.print_metrics(ss);
+    for (auto name : {"a", "square", "range"})
+      GF_CHECK(ss.str().find(name) != std::string::npos);
+
+    // one complete event per processed node
+    auto filepath = folder.file("trace.json");
+    N.dump_trace(filepath);
+    std::ifstream ifs(filepath);
+    json j;
+    ifs >> j;
+    size_t n_events = 0;
+    for (auto& event : j.at("traceEvents")) {
+      if (event.at("ph") != "X") continue;
+      ++n_events;
+      GF_CHECK(event.at("dur").get<double>() >= 0);
+      if (event.at("name") == "square")
+        GF_CHECK(event.at("dur").get<double>() >= 20000);
+    }
+    GF_CHECK(n_events == 6);
+
+    N.clear_trace();
+    N.dump_trace(filepath);
+    std::ifstream ifs_cleared(filepath);
+    ifs_cleared >> j;
+    GF_CHECK(j.at("traceEvents").empty());
+  }
+
+  return failures();
+}
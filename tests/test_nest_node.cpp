@@ -0,0 +1,178 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// the sequential, parallel and pipelined modes of NestNode must give the same results, in the same order
+
+#include "test_nodes.hpp"
+#include <geoflow/core_nodes.hpp>
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs its input as the single element of a poly output
+class AttributeNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_input("x", typeid(float));
+    add_poly_output("attributes", {typeid(float)});
+  }
+  void process() {
+    poly_output("attributes").add_vector("x", typeid(float)).push_back(input("x").get<float>());
+  }
+};
+
+// sums all elements of its poly input
+class PolySumNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_poly_input("attributes", {typeid(float)});
+    add_output("sum", typeid(float));
+  }
+  void process() {
+    float sum = 0;
+    for (auto& sub_term : poly_input("attributes").sub_terminals()) {
+      for (size_t i=0; i<sub_term->size(); ++i)
+        sum += sub_term->get<float>(i);
+    }
+    output("sum").set(sum);
+  }
+};
+
+// reads a point at x+1 and outputs the x of the data offset of its flowchart
+class OffsetNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_input("x", typeid(float));
+    add_output("offset", typeid(float));
+  }
+  void process() {
+    auto offset = manager.get_data_offset({input("x").get<float>()+1., 0., 0.});
+    output("offset").set(float(offset[0]));
+  }
+};
+
+// outputs the GF_I global, the index of the item that the nested flowchart processes
+class ItemIndexNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_input("x", typeid(float));
+    add_output("index", typeid(float));
+  }
+  void process() { output("index").set(std::stof(manager.substitute_globals("{{GF_I}}"))); }
+};
+
+// nested flowchart that computes x^4 for every item, and outputs x^2 as attribute
+void write_nested_flowchart(NodeRegisterMap& registers, NodeRegisterHandle R, const std::string& filepath) {
+  NodeManager nested(registers);
+  auto a = nested.create_node(R, "Square");
+  nested.name_node(a, "a");
+  set_param(*a, "sleep_ms", 2);
+  auto b = nested.create_node(R, "Square");
+  nested.name_node(b, "b");
+  connect(a, b, "y", "x");
+  auto c = nested.create_node(R, "Attribute");
+  nested.name_node(c, "c");
+  connect(a, c, "y", "x");
+  auto d = nested.create_node(R, "Offset");
+  nested.name_node(d, "d");
+  connect(a, d, "y", "x");
+  auto e = nested.create_node(R, "ItemIndex");
+  nested.name_node(e, "e");
+  connect(a, e, "y", "x");
+  a->input_terminals.at("x")->set_marked(true);
+  b->output_terminals.at("y")->set_marked(true);
+  c->output_terminals.at("attributes")->set_marked(true);
+  d->output_terminals.at("offset")->set_marked(true);
+  e->output_terminals.at("index")->set_marked(true);
+  nested.dump_json(filepath);
+}
+
+struct Mode {
+  std::string name;
+  bool parallel, pipelined;
+};
+
+int main() {
+  TempFolder folder("test_nest_node");
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<AttributeNode>("Attribute");
+  R->register_node<PolySumNode>("PolySum");
+  R->register_node<OffsetNode>("Offset");
+  R->register_node<ItemIndexNode>("ItemIndex");
+  registers.emplace(R);
+  auto R_core = NodeRegister::create("Core");
+  R_core->register_node<nodes::core::NestNode>("NestedFlowchart");
+  registers.emplace(R_core);
+  write_nested_flowchart(registers, R, folder.file("nested.json"));
+
+  for (int n_items : {0, 1, 23}) {
+    NodeManager N(registers);
+    auto range = N.create_node(R, "Range");
+    set_param(*range, "n", n_items);
+    auto nest = N.create_node(R_core, "NestedFlowchart");
+    set_param<std::string>(*nest, "filepath", folder.file("nested.json"));
+    nest->post_parameter_load();
+    GF_CHECK(connect(range, nest, "values", "a.x"));
+    // the poly output of the nest node must be ready for downstream nodes
+    auto poly_sum = N.create_node(R, "PolySum");
+    GF_CHECK(connect(nest->poly_output("c.attributes"), poly_sum->poly_input("attributes")));
+    float expected_sum = 0;
+    for (int i=0; i<n_items; ++i) expected_sum += i*i;
+
+    for (auto& mode : {Mode{"sequential", false, false}, Mode{"parallel", true, false}, Mode{"pipelined", false, true}}) {
+      set_param(*nest, "use_parallel_processing", mode.parallel);
+      set_param(*nest, "use_pipelining", mode.pipelined);
+      set_param(*nest, "n_threads", 4);
+      set_param(*nest, "items_in_flight", 3);
+      N.data_offset.reset();
+      N.run_all();
+      // a second run reuses the thread pool and must not see the results of the first run
+      N.data_offset.reset();
+      N.run_all();
+      auto& results = nest->vector_output("b.y");
+      if (!GF_CHECK(results.size() == size_t(n_items))) {
+        std::cerr << mode.name << " mode with " << n_items << " items\n";
+        continue;
+      }
+      auto& indices = nest->vector_output("e.index");
+      for (int i=0; i<n_items; ++i) {
+        if (!GF_CHECK(results.get<float>(i) == float(i*i*i*i) && indices.get<float>(i) == float(i)))
+          std::cerr << mode.name << " mode, item " << i << "\n";
+      }
+      // all items share the data offset of the outer flowchart
+      auto& offsets = nest->vector_output("d.offset");
+      if (n_items && GF_CHECK(N.data_offset.has_value())) {
+        for (int i=0; i<n_items; ++i) {
+          if (!GF_CHECK(offsets.get<float>(i) == float((*N.data_offset)[0])))
+            std::cerr << mode.name << " mode, offset of item " << i << "\n";
+        }
+      }
+      GF_CHECK(nest->vector_output(nest->get_name()+".timings").size() == size_t(n_items));
+      if (n_items) {
+        auto& sum = poly_sum->output("sum");
+        if (!GF_CHECK(sum.has_data() && sum.get<float>() == expected_sum))
+          std::cerr << mode.name << " mode, poly output\n";
+      }
+    }
+  }
+
+  return failures();
+}
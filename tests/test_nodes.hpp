@@ -0,0 +1,125 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include <geoflow/geoflow.hpp>
+
+// report a failed check and continue, a test returns the number of failed checks
+#define GF_CHECK(cond) geoflow::test::check((cond), #cond, __FILE__, __LINE__)
+
+// small nodes and helpers that are shared by the tests
+namespace geoflow::test {
+
+  inline int& failures() {
+    static int n_failures = 0;
+    return n_failures;
+  }
+  inline bool check(bool ok, const char* expr, const char* file, int line) {
+    if (!ok) {
+      std::cerr << file << ":" << line << ": check failed: " << expr << "\n";
+      ++failures();
+    }
+    return ok;
+  }
+
+  template<typename T> void set_param(Node& node, const std::string& name, T value) {
+    static_cast<ParameterByReference<T>*>(node.parameters.at(name).get())->set(value);
+  }
+
+  // folder for the files written by a test, removed when it goes out of scope
+  struct TempFolder {
+    fs::path path;
+    TempFolder(const std::string& name) : path(fs::temp_directory_path() / ("gf_" + name)) {
+      fs::remove_all(path);
+      fs::create_directories(path);
+    }
+    ~TempFolder() { fs::remove_all(path); }
+    std::string file(const std::string& filename) const { return (path / filename).string(); }
+  };
+
+  // outputs its value parameter
+  class NumberNode : public Node {
+    int value_=1;
+    public:
+    using Node::Node;
+    void init() {
+      add_output("value", typeid(float));
+      add_param(ParamInt(value_, "value", "Value"));
+    }
+    void process() { output("value").set(float(value_)); }
+  };
+
+  class AddNode : public Node {
+    public:
+    using Node::Node;
+    void init() {
+      add_input("a", typeid(float));
+      add_input("b", typeid(float));
+      add_output("sum", typeid(float));
+    }
+    void process() { output("sum").set(input("a").get<float>() + input("b").get<float>()); }
+  };
+
+  // outputs the values 0..n-1
+  class RangeNode : public Node {
+    int n_=5;
+    public:
+    using Node::Node;
+    void init() {
+      add_vector_output("values", typeid(float));
+      add_param(ParamInt(n_, "n", "Number of values"));
+    }
+    void process() {
+      auto& values = vector_output("values");
+      for (int i=0; i<n_; ++i) values.push_back(float(i));
+    }
+  };
+
+  // squares its input, optionally sleeping first to let other work overlap
+  class SquareNode : public Node {
+    int sleep_ms_=0;
+    public:
+    using Node::Node;
+    void init() {
+      add_input("x", typeid(float));
+      add_output("y", typeid(float));
+      add_param(ParamInt(sleep_ms_, "sleep_ms", "Time to sleep before processing"));
+    }
+    void process() {
+      if (sleep_ms_) std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms_));
+      float x = input("x").get<float>();
+      output("y").set(x*x);
+    }
+  };
+
+  inline NodeRegisterHandle create_register() {
+    auto R = NodeRegister::create("Test");
+    R->register_node<NumberNode>("Number");
+    R->register_node<AddNode>("Add");
+    R->register_node<RangeNode>("Range");
+    R->register_node<SquareNode>("Square");
+    return R;
+  }
+}
@@ -0,0 +1,127 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// geometries keep their absolute coordinates in double precision through conversions, rebasing and the disk cache
+
+#include <cmath>
+#include <sstream>
+#include <geoflow/common.hpp>
+#include <geoflow/kernels.hpp>
+#include <geoflow/serialisation.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+const size_t max_n = 70;
+const arr3d offset = {85000.5, 445000.25, -10.};
+
+// absolute coordinates near offset that can not be stored exactly as floats
+vec3d test_points(size_t n) {
+  vec3d points(n);
+  for (size_t i=0; i<n; ++i) points[i] = {offset[0] + i*0.123, offset[1] - i*0.456, offset[2] + i*0.01};
+  return points;
+}
+
+void test_kernels() {
+  for (size_t n=0; n<=max_n; ++n) {
+    auto points = test_points(n);
+    std::vector<float> local(3*n);
+    kernels::to_local(points.empty() ? nullptr : points[0].data(), n, offset.data(), local.data());
+    std::vector<double> global(3*n);
+    kernels::to_global(local.data(), n, offset.data(), global.data());
+    for (size_t i=0; i<3*n; ++i) {
+      double expected_local = points[i/3][i%3] - offset[i%3];
+      if (!GF_CHECK(local[i] == float(expected_local) && global[i] == double(local[i]) + offset[i%3])) {
+        std::cerr << "to_local/to_global n=" << n << " i=" << i << "\n";
+        break;
+      }
+    }
+
+    auto translated = local;
+    const double d[3] = {0.1, -1e5, 3.};
+    kernels::translate_xyz(translated.data(), n, d);
+    auto added = local;
+    kernels::add_double(added.data(), 3*n, 0.1);
+    for (size_t i=0; i<3*n; ++i) {
+      if (!GF_CHECK(translated[i] == float(double(local[i]) + d[i%3]) && added[i] == float(double(local[i]) + 0.1))) {
+        std::cerr << "translate_xyz/add_double n=" << n << " i=" << i << "\n";
+        break;
+      }
+    }
+  }
+}
+
+void test_geometry() {
+  auto absolute = test_points(max_n);
+  PointCollection points;
+  points.set_offset(offset);
+  for (auto& p : absolute) points.push_back(points.to_local(p));
+  for (size_t i=0; i<max_n; ++i) {
+    auto p = points.to_global(points[i]);
+    for (size_t j=0; j<3; ++j) GF_CHECK(std::abs(p[j] - absolute[i][j]) < 1e-3);
+  }
+
+  // rebasing changes the stored coordinates, not the absolute ones
+  auto before = points.to_global(points.back());
+  points.rebase({85100., 445100., 0.});
+  GF_CHECK(points.offset() == (arr3d{85100., 445100., 0.}));
+  auto after = points.to_global(points.back());
+  for (size_t j=0; j<3; ++j) GF_CHECK(std::abs(after[j] - before[j]) < 1e-3);
+
+  // batch conversions
+  auto local = to_local(absolute, offset);
+  auto global = to_global(local, offset);
+  GF_CHECK(global.size() == absolute.size());
+  for (size_t i=0; i<max_n; ++i)
+    for (size_t j=0; j<3; ++j) GF_CHECK(std::abs(global[i][j] - absolute[i][j]) < 1e-3);
+
+  // the disk cache keeps the offset
+  auto& serialisers = SerialiserRegistry::get();
+  std::stringstream ss;
+  serialisers.write(ss, std::any(points));
+  auto read = std::any_cast<PointCollection>(serialisers.read(ss));
+  GF_CHECK(read.offset() == points.offset());
+  GF_CHECK(read.size() == points.size() && read.back() == points.back());
+}
+
+// the first reader sets the data offset of the flowchart, all others get the same offset
+void test_data_offset() {
+  NodeRegisterMap registers;
+  NodeManager N(registers);
+  std::vector<arr3d> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i=0; i<results.size(); ++i)
+    threads.emplace_back([&N, &results, i]() { results[i] = N.get_data_offset({double(i), 0., 0.}); });
+  for (auto& t : threads) t.join();
+  GF_CHECK(N.data_offset.has_value());
+  for (auto& r : results) GF_CHECK(r == *N.data_offset);
+
+  PointCollection points;
+  points.set_offset({(*N.data_offset)[0] + 10., 0., 0.});
+  points.push_back({1.f, 2.f, 3.f});
+  N.align_offset(points);
+  GF_CHECK(points.offset() == *N.data_offset);
+  GF_CHECK(points[0] == (arr3f{11.f, 2.f, 3.f}));
+}
+
+int main() {
+  test_kernels();
+  test_geometry();
+  test_data_offset();
+  return failures();
+}
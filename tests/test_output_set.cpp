@@ -0,0 +1,99 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// set(), push_back() and emplace() on output terminals must move or construct the data in place instead of copying it
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// counts how often it was copied
+struct Tracked {
+  static inline int n_copies = 0;
+  std::vector<float> values;
+  Tracked() = default;
+  Tracked(size_t n) : values(n, 1.f) {};
+  Tracked(const Tracked& other) : values(other.values) { ++n_copies; };
+  Tracked(Tracked&& other) = default;
+  Tracked& operator=(const Tracked& other) { values = other.values; ++n_copies; return *this; };
+  Tracked& operator=(Tracked&& other) = default;
+};
+
+class TrackedSourceNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_output("moved", typeid(Tracked));
+    add_output("emplaced", typeid(Tracked));
+    add_vector_output("vector", typeid(Tracked));
+    add_vector_output<float>("column");
+    add_vector_output<Tracked>("tracked_column");
+    add_output("flag", typeid(bool));
+  }
+  void process() {
+    output("moved").set(Tracked(10));
+    auto& emplaced = output("emplaced").emplace<Tracked>(5);
+    emplaced.values.push_back(2.f);
+    auto& vector = vector_output("vector");
+    vector.push_back(Tracked(3));
+    vector.emplace_back<Tracked>(4).values[0] = 3.f;
+    auto& column = vector_output("column");
+    column.push_back(1.f);
+    column.emplace_back<float>(2.f) += 1.f;
+    output("flag").set(true);
+  }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<TrackedSourceNode>("TrackedSource");
+  registers.emplace(R);
+
+  NodeManager N(registers);
+  auto source = N.create_node(R, "TrackedSource");
+  N.run_all();
+  GF_CHECK(Tracked::n_copies == 0);
+
+  GF_CHECK(source->output("moved").get<const Tracked&>().values.size() == 10);
+  auto& emplaced = source->output("emplaced").get<const Tracked&>();
+  GF_CHECK(emplaced.values.size() == 6 && emplaced.values.back() == 2.f);
+  auto& vector = source->vector_output("vector");
+  GF_CHECK(vector.size() == 2);
+  GF_CHECK(vector.get<const Tracked&>(0).values.size() == 3);
+  GF_CHECK(vector.get<const Tracked&>(1).values[0] == 3.f);
+  auto& column = source->vector_output("column");
+  GF_CHECK(column.size() == 2 && column.get<float>(1) == 3.f);
+  GF_CHECK(source->output("flag").get<bool>());
+
+  // setting an lvalue copies it once
+  Tracked tracked(2);
+  source->output("moved").set(tracked);
+  GF_CHECK(Tracked::n_copies == 1);
+
+  // an element taken out with get_any() is copied once and then moved into another terminal, eg. by NestNode
+  for (auto target_name : {"vector", "tracked_column"}) {
+    Tracked::n_copies = 0;
+    auto& target = source->vector_output(target_name);
+    target.set_from_any(source->output("moved").get_any(0));
+    target.push_back_any(source->output("moved").get_any(0));
+    GF_CHECK(Tracked::n_copies == 2);
+    GF_CHECK(target.size() == 2 && target.get<const Tracked&>(1).values.size() == 2);
+  }
+
+  return failures();
+}
@@ -0,0 +1,97 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// packed ring collections must keep every ring, including empty ones, through conversions and the disk cache
+
+#include <sstream>
+#include <geoflow/common.hpp>
+#include <geoflow/serialisation.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// rings of 0..n_rings-1 vertices
+std::vector<vec3f> test_rings(size_t n_rings) {
+  std::vector<vec3f> rings(n_rings);
+  for (size_t i=0; i<n_rings; ++i)
+    for (size_t j=0; j<i; ++j) rings[i].push_back({float(i), float(j), float(i*j)});
+  return rings;
+}
+
+template<typename Packed> void check_packed(const Packed& packed, const std::vector<vec3f>& rings) {
+  GF_CHECK(packed.size() == rings.size());
+  GF_CHECK(packed.unpack() == rings);
+  size_t n = 0;
+  for (size_t i=0; i<rings.size(); ++i) {
+    GF_CHECK(packed.ring_size(i) == rings[i].size());
+    GF_CHECK(packed.offsets()[i] == n);
+    n += rings[i].size();
+  }
+  GF_CHECK(packed.vertex_count() == n && packed.offsets().back() == n);
+}
+
+int main() {
+  auto rings = test_rings(7);
+
+  LineStringCollection linestrings;
+  LinearRingCollection linear_rings;
+  linestrings.set_offset({10., 20., 30.});
+  linear_rings.set_offset({-10., 5., 0.});
+  for (auto& ring : rings) {
+    linestrings.push_back(ring);
+    linear_rings.push_back(ring);
+  }
+
+  PackedLineStringCollection packed_linestrings(linestrings);
+  check_packed(packed_linestrings, rings);
+  GF_CHECK(packed_linestrings.offset() == linestrings.offset());
+  auto linestrings_back = packed_linestrings.to_collection();
+  GF_CHECK(linestrings_back.offset() == linestrings.offset());
+  GF_CHECK(std::equal(linestrings_back.begin(), linestrings_back.end(), linestrings.begin(), linestrings.end()));
+
+  PackedLinearRingCollection packed_rings(linear_rings);
+  check_packed(packed_rings, rings);
+  auto rings_back = packed_rings.to_collection();
+  GF_CHECK(rings_back.offset() == linear_rings.offset());
+  GF_CHECK(std::equal(rings_back.begin(), rings_back.end(), linear_rings.begin(), linear_rings.end()));
+
+  // filling vertex by vertex gives the same result as push_back()
+  PackedLinearRingCollection built;
+  for (auto& ring : rings) {
+    for (auto& p : ring) built.add_vertex(p);
+    built.end_ring();
+  }
+  check_packed(built, rings);
+  GF_CHECK(built.vertices() == packed_rings.vertices());
+
+  // one buffer with every vertex, and a box over all rings
+  GF_CHECK(packed_rings.get_data_ptr() == packed_rings.vertices()[0].data());
+  GF_CHECK(packed_rings.box().max() == (arr3f{6, 5, 30}));
+  packed_rings.clear();
+  GF_CHECK(packed_rings.empty() && packed_rings.get_data_ptr() == nullptr);
+
+  // disk cache round trip
+  auto& serialisers = SerialiserRegistry::get();
+  std::stringstream ss;
+  serialisers.write(ss, std::any(packed_linestrings));
+  auto read = std::any_cast<PackedLineStringCollection>(serialisers.read(ss));
+  check_packed(read, rings);
+  GF_CHECK(read.offset() == packed_linestrings.offset());
+
+  return failures();
+}
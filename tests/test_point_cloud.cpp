@@ -0,0 +1,123 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// the SIMD kernels must match a scalar reference for every input size, including the elements after the last full
+// vector, and PointCloud must keep its points and attributes through conversions, filters and translations
+
+#include <cmath>
+#include <geoflow/common.hpp>
+#include <geoflow/kernels.hpp>
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// sizes up to a few times the widest vector (8 floats for AVX2), so that every remainder length is covered
+const size_t max_n = 70;
+
+// deterministic values in [-50, 50], with the extremes at varying positions
+std::vector<float> test_values(size_t n) {
+  std::vector<float> v(n);
+  for (size_t i=0; i<n; ++i) v[i] = float(int((i*37) % 101) - 50) + 0.25f;
+  return v;
+}
+
+void test_kernels() {
+  for (size_t n=0; n<=max_n; ++n) {
+    // start one element into the buffer so that the loads are unaligned
+    auto buffer = test_values(n+1);
+    float* v = buffer.data()+1;
+
+    float vmin = 1e9, vmax = -1e9;
+    kernels::minmax(v, n, vmin, vmax);
+    if (n == 0) {
+      GF_CHECK(vmin == 1e9f && vmax == -1e9f);
+    } else {
+      if (!GF_CHECK(vmin == *std::min_element(v, v+n) && vmax == *std::max_element(v, v+n)))
+        std::cerr << "minmax n=" << n << "\n";
+    }
+
+    auto added = std::vector<float>(v, v+n);
+    kernels::add_scalar(added.data(), n, 1.5f);
+    for (size_t i=0; i<n; ++i) {
+      if (!GF_CHECK(added[i] == v[i]+1.5f)) {
+        std::cerr << "add_scalar n=" << n << " i=" << i << "\n";
+        break;
+      }
+    }
+
+    std::vector<unsigned char> mask(n, 1);
+    if (n) mask[0] = 0;
+    kernels::mask_range(v, n, -10.f, 20.f, mask.data());
+    for (size_t i=0; i<n; ++i) {
+      bool expected = i!=0 && v[i] >= -10.f && v[i] <= 20.f;
+      if (!GF_CHECK(bool(mask[i]) == expected)) {
+        std::cerr << "mask_range n=" << n << " i=" << i << "\n";
+        break;
+      }
+    }
+  }
+}
+
+void test_point_cloud() {
+  PointCollection points;
+  points.set_offset({1000., 2000., 0.});
+  for (size_t i=0; i<max_n; ++i) points.push_back({float(i), float(i)*2, float(i)*0.5f});
+
+  PointCloud cloud(points);
+  GF_CHECK(cloud.size() == max_n);
+  GF_CHECK(cloud.offset() == points.offset());
+  auto& height = cloud.add_attribute("height");
+  for (size_t i=0; i<max_n; ++i) height[i] = float(i)+0.5f;
+
+  // round trip
+  auto back = cloud.to_point_collection();
+  GF_CHECK(back.size() == points.size() && back.offset() == points.offset());
+  GF_CHECK(std::equal(back.begin(), back.end(), points.begin()));
+  // the coordinates are only stored as columns, there is no interleaved vertex buffer
+  GF_CHECK(cloud.get_data_ptr() == nullptr);
+
+  auto& box = cloud.box();
+  GF_CHECK(box.min() == (arr3f{0, 0, 0}));
+  GF_CHECK(box.max() == (arr3f{float(max_n-1), float(max_n-1)*2, float(max_n-1)*0.5f}));
+
+  // filter keeps the attributes of the selected points
+  Box range;
+  range.set({9.5f, 0, 0}, {20.5f, 1000, 0});
+  auto inside = cloud.filter(range);
+  GF_CHECK(inside.size() == 11);
+  GF_CHECK(inside.offset() == cloud.offset());
+  if (GF_CHECK(inside.has_attribute("height") && inside.attribute("height").size() == 11)) {
+    GF_CHECK(inside[0][0] == 10.f && inside.attribute("height")[0] == 10.5f);
+  }
+  GF_CHECK(cloud.filter(range, true).size() == 0);
+
+  // translations are computed in double precision and update the box
+  PointCloud far;
+  far.push_back({0.1f, 0.2f, 0.3f});
+  far.translate({1e6, 0., -1e6});
+  GF_CHECK(far.x()[0] == float(double(0.1f) + 1e6));
+  GF_CHECK(far.z()[0] == float(double(0.3f) - 1e6));
+  GF_CHECK(far.box().min()[0] == far.x()[0]);
+}
+
+int main() {
+  std::cout << "kernels use " << kernels::instruction_set() << "\n";
+  test_kernels();
+  test_point_cloud();
+  return failures();
+}
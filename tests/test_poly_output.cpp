@@ -0,0 +1,100 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// a poly output must be ready for the connected nodes however its sub terminals were filled, and output data is
+// only visible to other nodes once it was propagated
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// fills a poly output with n_elements per sub terminal, through push_back() or push_back_any()
+class PolySourceNode : public Node {
+  int n_elements_=1;
+  bool use_any_=false;
+  public:
+  using Node::Node;
+  void init() {
+    add_poly_output("attributes", {typeid(float)});
+    add_param(ParamInt(n_elements_, "n_elements", "Number of elements per sub terminal"));
+    add_param(ParamBool(use_any_, "use_any", "Fill the sub terminals with push_back_any()"));
+  }
+  void process() {
+    auto& attributes = poly_output("attributes");
+    for (auto name : {"a", "b"}) {
+      auto& sub_term = attributes.add_vector(name, typeid(float));
+      for (int i=0; i<n_elements_; ++i) {
+        if (use_any_)
+          sub_term.push_back_any(std::any(float(i)));
+        else
+          sub_term.push_back(float(i));
+      }
+    }
+  }
+};
+
+// sums all elements of its poly input
+class PolySinkNode : public Node {
+  public:
+  float sum = -1;
+  using Node::Node;
+  void init() { add_poly_input("attributes", {typeid(float)}); }
+  void process() {
+    sum = 0;
+    for (auto& sub_term : poly_input("attributes").sub_terminals()) {
+      for (size_t i=0; i<sub_term->size(); ++i)
+        sum += sub_term->get<float>(i);
+    }
+  }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<PolySourceNode>("PolySource");
+  R->register_node<PolySinkNode>("PolySink");
+  registers.emplace(R);
+
+  for (size_t n_threads : {1, 4}) {
+    for (bool use_any : {false, true}) {
+      for (int n_elements : {1, 3}) {
+        NodeManager N(registers);
+        N.n_threads = n_threads;
+        auto source = N.create_node(R, "PolySource");
+        auto sink = N.create_node(R, "PolySink");
+        set_param(*source, "n_elements", n_elements);
+        set_param(*source, "use_any", use_any);
+        GF_CHECK(connect(source->poly_output("attributes"), sink->poly_input("attributes")));
+        N.run_all();
+        GF_CHECK(source->poly_output("attributes").has_data());
+        if (!GF_CHECK(static_cast<PolySinkNode*>(sink.get())->sum == float(n_elements*(n_elements-1))))
+          std::cerr << "n_threads=" << n_threads << " use_any=" << use_any << " n_elements=" << n_elements << "\n";
+      }
+    }
+  }
+
+  // data is visible to the writing thread right away, and to the connected nodes once it is propagated
+  NodeManager N(registers);
+  auto source = N.create_node(R, "PolySource");
+  auto& attributes = source->poly_output("attributes");
+  attributes.add_vector("a", typeid(float)).push_back_any(std::any(1.f));
+  GF_CHECK(attributes.has_data() && !attributes.is_published());
+  N.run_all();
+  GF_CHECK(attributes.has_data() && attributes.is_published());
+
+  return failures();
+}
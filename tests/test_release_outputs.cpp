@@ -0,0 +1,95 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// run_all() frees the outputs that all connected nodes have read, unless they are marked with keep_data
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+const size_t buffer_size = 1<<18;
+
+class BufferNode : public Node {
+  public:
+  using Node::Node;
+  void init() { add_output("buffer", typeid(std::vector<float>)); }
+  void process() { output("buffer").set(std::vector<float>(buffer_size, 1.f)); }
+};
+
+// adds one to every element of the buffer
+class IncrementNode : public Node {
+  public:
+  using Node::Node;
+  void init() {
+    add_input("buffer", typeid(std::vector<float>));
+    add_output("buffer", typeid(std::vector<float>));
+  }
+  void process() {
+    std::vector<float> buffer(input("buffer").get<const std::vector<float>&>());
+    for (auto& x : buffer) x += 1;
+    output("buffer").set(std::move(buffer));
+  }
+};
+
+void test_release(NodeRegisterMap& registers, NodeRegisterHandle R, size_t n_threads) {
+  MemoryReport reports[2];
+  for (bool release : {false, true}) {
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    N.release_consumed_outputs = release;
+    std::vector<NodeHandle> chain{N.create_node(R, "Buffer")};
+    for (int i=0; i<8; ++i) {
+      auto node = N.create_node(R, "Increment");
+      connect(chain.back(), node, "buffer", "buffer");
+      chain.push_back(node);
+    }
+    chain[4]->output("buffer").set_keep_data(true);
+    N.run_all();
+
+    auto& last = chain.back()->output("buffer");
+    if (GF_CHECK(last.has_data()))
+      GF_CHECK(last.get<const std::vector<float>&>()[0] == 9.f);
+    GF_CHECK(chain[4]->output("buffer").has_data());
+    size_t n_with_data = 0;
+    for (auto& node : chain) n_with_data += node->output("buffer").has_data();
+
+    auto& report = reports[release] = N.get_memory_report();
+    if (release) {
+      // only the last output and the one with keep_data hold their data
+      GF_CHECK(n_with_data == 2);
+      GF_CHECK(report.released_terminals == chain.size()-2);
+      GF_CHECK(report.released_output_bytes >= report.released_terminals * buffer_size * sizeof(float));
+    } else {
+      GF_CHECK(n_with_data == chain.size());
+      GF_CHECK(report.released_terminals == 0);
+    }
+  }
+  GF_CHECK(reports[1].peak_output_bytes < reports[0].peak_output_bytes);
+}
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<BufferNode>("Buffer");
+  R->register_node<IncrementNode>("Increment");
+  registers.emplace(R);
+
+  test_release(registers, R, 1);
+  test_release(registers, R, 4);
+
+  return failures();
+}
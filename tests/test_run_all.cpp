@@ -0,0 +1,91 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// run_all() with one thread and with a thread pool must give the same results
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// a tree of Add nodes that sums the values 1..n_leaves, returns the root
+NodeHandle create_sum_tree(NodeManager& N, NodeRegisterHandle R, int n_leaves) {
+  // nodes of the current level of the tree and the names of their outputs
+  std::vector<std::pair<NodeHandle, std::string>> level;
+  for (int i=1; i<=n_leaves; ++i) {
+    auto number = N.create_node(R, "Number");
+    set_param(*number, "value", i);
+    level.push_back({number, "value"});
+  }
+  while (level.size() > 1) {
+    std::vector<std::pair<NodeHandle, std::string>> next_level;
+    for (size_t i=0; i+1<level.size(); i+=2) {
+      auto add = N.create_node(R, "Add");
+      connect(level[i].first, add, level[i].second, "a");
+      connect(level[i+1].first, add, level[i+1].second, "b");
+      next_level.push_back({add, "sum"});
+    }
+    if (level.size() % 2) next_level.push_back(level.back());
+    level = next_level;
+  }
+  return level[0].first;
+}
+
+float run_sum_tree(size_t n_threads, int n_leaves) {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  registers.emplace(R);
+  NodeManager N(registers);
+  N.n_threads = n_threads;
+  auto root = create_sum_tree(N, R, n_leaves);
+  N.run_all();
+  GF_CHECK(root->output("sum").has_data());
+  return root->output("sum").get<float>();
+}
+
+int main() {
+  const int n_leaves = 37;
+  const float expected = n_leaves*(n_leaves+1)/2;
+  GF_CHECK(run_sum_tree(1, n_leaves) == expected);
+  for (size_t n_threads : {2, 4, 0}) {
+    GF_CHECK(run_sum_tree(n_threads, n_leaves) == expected);
+  }
+
+  // running again after a parameter change updates the downstream nodes in both modes
+  NodeRegisterMap registers;
+  auto R = create_register();
+  registers.emplace(R);
+  for (size_t n_threads : {1, 4}) {
+    NodeManager N(registers);
+    N.n_threads = n_threads;
+    auto a = N.create_node(R, "Number");
+    auto b = N.create_node(R, "Number");
+    auto add = N.create_node(R, "Add");
+    auto square = N.create_node(R, "Square");
+    connect(a, add, "value", "a");
+    connect(b, add, "value", "b");
+    connect(add, square, "sum", "x");
+    set_param(*a, "value", 2);
+    set_param(*b, "value", 3);
+    N.run_all();
+    GF_CHECK(square->output("y").get<float>() == 25);
+    set_param(*b, "value", 1);
+    N.run_all();
+    GF_CHECK(square->output("y").get<float>() == 9);
+  }
+
+  return failures();
+}
@@ -0,0 +1,116 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// with streaming enabled nodes process the batches of their upstream node while it is running, with the same results
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs the values 0..n-1, and emits a batch every batch_size values
+class BatchRangeNode : public Node {
+  int n_=100, batch_size_=10;
+  public:
+  using Node::Node;
+  void init() {
+    add_vector_output("values", typeid(float));
+    add_param(ParamInt(n_, "n", "Number of values"));
+    add_param(ParamInt(batch_size_, "batch_size", "Number of values per batch"));
+  }
+  void process() {
+    auto& values = vector_output("values");
+    for (int i=0; i<n_; ++i) {
+      values.push_back(float(i));
+      if ((i+1) % batch_size_ == 0) emit_batch();
+    }
+  }
+};
+
+// squares every element of its input, one batch at a time
+class StreamSquareNode : public Node {
+  public:
+  std::atomic<int> n_calls{0};
+  using Node::Node;
+  void init() {
+    add_vector_input("x", typeid(float));
+    add_vector_output("y", typeid(float));
+  }
+  bool supports_streaming() const override { return true; };
+  void process() {
+    ++n_calls;
+    auto& x = vector_input("x");
+    auto& y = vector_output("y");
+    for (size_t i=0; i<x.size(); ++i) y.push_back(x.get<float>(i)*x.get<float>(i));
+    emit_batch();
+  }
+};
+
+// sums its input, does not support streaming
+class SumNode : public Node {
+  public:
+  float sum = -1;
+  using Node::Node;
+  void init() { add_vector_input("values", typeid(float)); }
+  void process() {
+    sum = 0;
+    auto& values = vector_input("values");
+    for (size_t i=0; i<values.size(); ++i) sum += values.get<float>(i);
+  }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<BatchRangeNode>("BatchRange");
+  R->register_node<StreamSquareNode>("StreamSquare");
+  R->register_node<SumNode>("Sum");
+  registers.emplace(R);
+
+  const int n = 100;
+  float expected = 0;
+  for (int i=0; i<n; ++i) expected += float(i*i);
+
+  for (bool streaming : {false, true}) {
+    for (size_t n_threads : {1, 4}) {
+      NodeManager N(registers);
+      N.n_threads = n_threads;
+      N.streaming = streaming;
+      N.stream_buffer_size = 2;
+      auto range = N.create_node(R, "BatchRange");
+      auto square = N.create_node(R, "StreamSquare");
+      auto sum = N.create_node(R, "Sum");
+      set_param(*range, "n", n);
+      connect(range, square, "values", "x");
+      connect(square, sum, "y", "values");
+      N.run_all();
+
+      auto square_node = static_cast<StreamSquareNode*>(square.get());
+      auto sum_node = static_cast<SumNode*>(sum.get());
+      if (!GF_CHECK(sum_node->sum == expected))
+        std::cerr << "streaming=" << streaming << " n_threads=" << n_threads << "\n";
+      // one call per batch when streaming
+      if (streaming)
+        GF_CHECK(square_node->n_calls == n/10);
+      else
+        GF_CHECK(square_node->n_calls == 1);
+      // the output of the streaming consumer is kept because its child does not support streaming
+      GF_CHECK(square->vector_output("y").size() == size_t(n));
+    }
+  }
+
+  return failures();
+}
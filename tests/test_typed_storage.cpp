@@ -0,0 +1,107 @@
+// This file is part of Geoflow
+// Copyright (C) 2018-2019  Ravi Peters, 3D geoinformation TU Delft
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// vector outputs with typed storage must be readable through spans and through the std::any accessors
+
+#include "test_nodes.hpp"
+
+using namespace geoflow;
+using namespace geoflow::test;
+
+// outputs the values 0..n-1 in typed storage, either with push_back() or by filling the column in place
+class TypedRangeNode : public Node {
+  int n_=5;
+  bool in_place_=false;
+  public:
+  using Node::Node;
+  void init() {
+    add_vector_output<float>("values");
+    add_param(ParamInt(n_, "n", "Number of values"));
+    add_param(ParamBool(in_place_, "in_place", "Fill the column in place"));
+  }
+  void process() {
+    auto& values = vector_output("values");
+    if (in_place_) {
+      auto& column = values.get_column<float>();
+      column.reserve(n_);
+      for (int i=0; i<n_; ++i) column.push_back(float(i));
+    } else {
+      for (int i=0; i<n_; ++i) values.push_back(float(i));
+    }
+  }
+};
+
+// sums its input through a span and through get<T>(i)
+class SpanSumNode : public Node {
+  public:
+  float span_sum = -1, get_sum = -1;
+  bool contiguous = false;
+  using Node::Node;
+  void init() { add_vector_input("values", typeid(float)); }
+  void process() {
+    auto& values = vector_input("values");
+    contiguous = values.is_contiguous();
+    span_sum = get_sum = 0;
+    for (auto& v : values.get_span<float>()) span_sum += v;
+    for (size_t i=0; i<values.size(); ++i) get_sum += values.get<float>(i);
+  }
+};
+
+int main() {
+  NodeRegisterMap registers;
+  auto R = create_register();
+  R->register_node<TypedRangeNode>("TypedRange");
+  R->register_node<SpanSumNode>("SpanSum");
+  registers.emplace(R);
+
+  for (bool in_place : {false, true}) {
+    for (int n : {0, 1, 100}) {
+      NodeManager N(registers);
+      auto range = N.create_node(R, "TypedRange");
+      auto sum = N.create_node(R, "SpanSum");
+      set_param(*range, "n", n);
+      set_param(*range, "in_place", in_place);
+      GF_CHECK(connect(range, sum, "values", "values"));
+      N.run_all();
+      auto& output = range->vector_output("values");
+      GF_CHECK(output.is_contiguous());
+      GF_CHECK(output.size() == size_t(n));
+      GF_CHECK(output.has_data() == (n>0));
+      auto sum_node = static_cast<SpanSumNode*>(sum.get());
+      if (n == 0) continue;
+      GF_CHECK(sum_node->contiguous);
+      float expected = n*(n-1)/2;
+      if (!GF_CHECK(sum_node->span_sum == expected && sum_node->get_sum == expected))
+        std::cerr << "in_place=" << in_place << " n=" << n << "\n";
+      GF_CHECK(std::any_cast<float>(output.get_any(n-1)) == float(n-1));
+    }
+  }
+
+  // terminals without typed storage have no column and no span
+  NodeManager N(registers);
+  auto range = N.create_node(R, "Range");
+  N.run_all();
+  auto& output = range->vector_output("values");
+  GF_CHECK(!output.is_contiguous());
+  bool thrown = false;
+  try { output.get_column<float>(); } catch (const gfException&) { thrown = true; }
+  GF_CHECK(thrown);
+  thrown = false;
+  try { output.get_span<float>(); } catch (const gfException&) { thrown = true; }
+  GF_CHECK(thrown);
+
+  return failures();
+}